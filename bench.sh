@@ -3,66 +3,96 @@ set -euo pipefail
 
 cd "$(dirname "$0")"
 
-HVM=./HVM4/clang/main
-RUNS="${1:-5}"
-
-if [ ! -x "$HVM" ]; then
-  echo "HVM4 not built. Run ./build.sh first."
-  exit 1
-fi
-
 declare -A FLAGS
 FLAGS[sup_enum]="-C10"
 
-FILES=(src/path_*.hvm4)
+# Profile mode: ./bench.sh --profile [FILE.hvm4 ...]
+# Builds the bridge runner with -DHVM4_PROFILE and evaluates each file once,
+# printing a per-definition table and writing collapsed stacks of the same
+# run to prof/<name>.folded (feed to flamegraph.pl or speedscope).
+if [ "${1:-}" = "--profile" ]; then
+  shift
+  PROF=./bench/hvm4_run_prof
+  if [ ! -f HVM4/clang/hvm4.c ]; then
+    echo "HVM4 sources missing. Run: git submodule update --init"
+    exit 1
+  fi
+  ${CC:-clang} -O2 -DHVM4_PROFILE -o "$PROF" bench/hvm4_run.c -lpthread
+  mkdir -p prof
+  if [ $# -gt 0 ]; then FILES=("$@"); else FILES=(src/path_*.hvm4); fi
+  for f in "${FILES[@]}"; do
+    name=$(basename "$f" .hvm4)
+    short=${name#path_}
+    extra="${FLAGS[$short]:-}"
+    echo "=== $name ==="
+    "$PROF" $extra --profile=table --folded="prof/$name.folded" "$f"
+    echo ""
+  done
+  echo "Collapsed stacks written to prof/*.folded"
+  exit 0
+fi
+
+# Default mode: ./bench.sh [RUNS] [table|csv|json]
+# All src/path_*.hvm4 files run in-process through bench/hvm4_bench: one
+# warmup plus RUNS timed evaluations each, no per-run fork of HVM4/clang/main.
+#
+# Regression mode: ./bench.sh --baseline | --check [TOLERANCE_PCT]
+# One single-threaded evaluation of every src/path_*.hvm4 and bench/*.hvm4;
+# --baseline records interactions, result hash and heap words in
+# bench/baseline.tsv, --check diffs against it and exits 1 on any growth
+# beyond the tolerance (default 1%), any changed result or any baseline
+# program that did not run. bench/baseline.tsv is committed for the pinned
+# HVM4 revision; re-record it with --baseline when the submodule moves or a
+# change is meant to alter the counts, and commit it with that change.
+BENCH=./bench/hvm4_bench
+BASELINE=bench/baseline.tsv
+
+if [ ! -f HVM4/clang/hvm4.c ]; then
+  echo "HVM4 sources missing. Run: git submodule update --init"
+  exit 1
+fi
 
-printf "%-26s %10s %12s %14s %10s\n" \
-  "Algorithm" "Itrs" "Time (us)" "Perf (MIPS)" "RSS (KB)"
-printf '%.0s-' {1..76}
-echo ""
+if [ ! -x "$BENCH" ] || [ bench/hvm4_bench.c -nt "$BENCH" ] \
+   || [ c3lib/csrc/hvm4_bridge.c -nt "$BENCH" ]; then
+  ${CC:-clang} -O2 -o "$BENCH" bench/hvm4_bench.c -lpthread
+fi
 
-for f in "${FILES[@]}"; do
+# Plain files first, then each file with extra flags (-C N is sticky in
+# hvm4_bench, so reset it with -C0 after every flagged file).
+ARGS=()
+FLAGGED=()
+for f in src/path_*.hvm4; do
   name=$(basename "$f" .hvm4)
   short=${name#path_}
-  extra="${FLAGS[$short]:-}"
-
-  best_us=""
-  best_itrs=""
-  best_perf=""
-  best_result=""
-  best_rss=""
-
-  for ((r = 1; r <= RUNS; r++)); do
-    # Wall-clock via nanosecond timestamps
-    t0=$(date +%s%N)
-    raw=$("$HVM" "$f" -s $extra 2>&1)
-    t1=$(date +%s%N)
-    wall_us=$(( (t1 - t0) / 1000 ))
-
-    # Result lines (strip ANSI interaction counts)
-    result=$(echo "$raw" | sed 's/ \x1b\[2m#[0-9]*\x1b\[0m//g' | grep -v '^- ' | tr '\n' ' ' | sed 's/ *$//')
-
-    # Interactions
-    itrs=$(echo "$raw" | grep -oP 'Itrs: \K[0-9]+' || echo "0")
-
-    # Perf (MIPS) from HVM4
-    perf=$(echo "$raw" | grep -oP 'Perf: \K[0-9.]+' || echo "0")
+  if [ -n "${FLAGS[$short]:-}" ]; then
+    FLAGGED+=("${FLAGS[$short]}" "$f" -C0)
+  else
+    ARGS+=("$f")
+  fi
+done
 
-    # Peak RSS via /usr/bin/time -v
-    rss=$( { /usr/bin/time -v "$HVM" "$f" $extra > /dev/null; } 2>&1 | grep -oP 'Maximum resident set size.*: \K[0-9]+' || echo "0")
+ALL=("${ARGS[@]}" ${FLAGGED[@]+"${FLAGGED[@]}"} bench/*.hvm4)
+if [ "${1:-}" = "--baseline" ]; then
+  HVM4_THREADS=1 "$BENCH" --runs=1 --warmup=0 --format=csv \
+    --write-baseline="$BASELINE" "${ALL[@]}" > /dev/null
+  echo "Baseline written to $BASELINE"
+  exit 0
+fi
+if [ "${1:-}" = "--check" ]; then
+  if [ ! -f "$BASELINE" ]; then
+    echo "No $BASELINE yet. Record one first: ./bench.sh --baseline"
+    exit 1
+  fi
+  HVM4_THREADS=1 exec "$BENCH" --runs=1 --warmup=0 \
+    --check="$BASELINE" --tolerance="${2:-1}" "${ALL[@]}"
+fi
 
-    if [ -z "$best_us" ] || [ "$wall_us" -lt "$best_us" ]; then
-      best_us="$wall_us"
-      best_itrs="$itrs"
-      best_perf="$perf"
-      best_result="$result"
-      best_rss="$rss"
-    fi
-  done
+RUNS="${1:-5}"
+FORMAT="${2:-table}"
 
-  printf "%-26s %10s %12s %14s %10s\n" \
-    "$short" "$best_itrs" "$best_us" "$best_perf" "$best_rss"
-done
+"$BENCH" --runs="$RUNS" --format="$FORMAT" "${ARGS[@]}" ${FLAGGED[@]+"${FLAGGED[@]}"}
 
-echo ""
-echo "Best of $RUNS runs. Time = wall-clock microseconds. Perf = M interactions/s (from HVM4). RSS = peak resident set (KB)."
+if [ "$FORMAT" = "table" ]; then
+  echo ""
+  echo "$RUNS timed runs after 1 warmup, in-process. Times = evaluation only (us). MIPS = M interactions/s at the min time. dRSS = resident growth during evaluation (KB)."
+fi
@@ -0,0 +1,432 @@
+// APSP benchmark: HVM4 tree squaring vs the native blocked kernel
+// Compile: clang -O2 -o bench/apsp_bench bench/apsp_bench.c bench/graphgen.c -lpthread -lm
+// Usage:   ./bench/apsp_bench [V1,V2,...] [edges_per_node] [--threads=1,2,4,...]
+//                            [--tiled] [--hvm-max=V]
+//
+// Graphs come from graphgen_geometric (both directions, weight ~ length),
+// the shape of the SWR PRMs. For each V the driver runs the program
+// pathfind::algebraic_apsp generates (row trees, or the quadtree with
+// --tiled), then apsp_native (c3lib/csrc/apsp_kernel.c) once per thread
+// count, and prints wall time per backend. Every matrix must equal the
+// one-thread native result, which is itself checked against a plain
+// Floyd-Warshall up to V = 512.
+//
+// --hvm-max=V  skip the HVM4 run above V nodes (default 1024): it is
+//              O(n^3 log n) interactions and dominates the sweep.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../c3lib/csrc/hvm4_bridge.c"
+#include "../c3lib/csrc/apsp_kernel.c"
+#include "graphgen.h"
+#include "thread_sweep.h"
+
+// ---------------------------------------------------------------------------
+// Growable source buffer (the matrix literal is O(E log V) bytes)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+  char  *buf;
+  size_t pos, cap;
+} sbuf_t;
+
+static void sb_reserve(sbuf_t *sb, size_t more) {
+  if (sb->pos + more + 1 <= sb->cap) return;
+  while (sb->pos + more + 1 > sb->cap) sb->cap = sb->cap ? sb->cap * 2 : 65536;
+  sb->buf = realloc(sb->buf, sb->cap);
+  if (!sb->buf) { fprintf(stderr, "apsp_bench: out of memory\n"); exit(1); }
+}
+
+static void sb_puts(sbuf_t *sb, const char *s) {
+  size_t l = strlen(s);
+  sb_reserve(sb, l);
+  memcpy(sb->buf + sb->pos, s, l + 1);
+  sb->pos += l;
+}
+
+static void sb_putu(sbuf_t *sb, const char *fmt, uint32_t v) {
+  sb_reserve(sb, 64);
+  sb->pos += snprintf(sb->buf + sb->pos, 64, fmt, v);
+}
+
+// ---------------------------------------------------------------------------
+// HVM4 source generation (same templates and emitters as apsp_run in
+// c3lib/src/pathfind.c3)
+// ---------------------------------------------------------------------------
+
+// UTF-8 lambda: split to avoid C hex escape merging (\xcebb would be one escape)
+#define L "\xce" "\xbb"
+
+static const char *APSP_ROW_DEFS =
+    "@v_min = " L "{\n"
+    "  #VE: " L "b. b;\n"
+    "  #VL: " L "&x. " L "{\n"
+    "    #VE: #VL{x};\n"
+    "    #VL: " L "&y. #VL{" L "{0: y; " L "c. x}(x < y)};\n"
+    "    #VN: " L "lo. " L "hi. #VE{}\n"
+    "  };\n"
+    "  #VN: " L "&alo. " L "&ahi. " L "{\n"
+    "    #VE: #VN{alo, ahi};\n"
+    "    #VL: " L "y. #VE{};\n"
+    "    #VN: " L "blo. " L "bhi. #VN{@v_min(alo, blo), @v_min(ahi, bhi)}\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "@v_add = " L "&a. " L "{\n"
+    "  #VE: #VE{};\n"
+    "  #VL: " L "x. #VL{a + x};\n"
+    "  #VN: " L "lo. " L "hi. #VN{@v_add(a, lo), @v_add(a, hi)}\n"
+    "}\n"
+    "\n"
+    "@mm_row = " L "{\n"
+    "  #VE: " L "b. #VE{};\n"
+    "  #VL: " L "a. " L "{#VE: #VE{}; #VL: " L "row. @v_add(a, row); #VN: " L "lo. " L "hi. #VE{}};\n"
+    "  #VN: " L "alo. " L "ahi. " L "{\n"
+    "    #VE: #VE{};\n"
+    "    #VL: " L "row. #VE{};\n"
+    "    #VN: " L "blo. " L "bhi. @v_min(@mm_row(alo, blo), @mm_row(ahi, bhi))\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "@mm_rows = " L "&b. " L "{\n"
+    "  #VE: #VE{};\n"
+    "  #VL: " L "row. #VL{@mm_row(row, b)};\n"
+    "  #VN: " L "lo. " L "hi. #VN{@mm_rows(b, lo), @mm_rows(b, hi)}\n"
+    "}\n"
+    "\n"
+    "@mat_mul = " L "a. " L "b. @mm_rows(b, a)\n"
+    "\n"
+    "@v_eq = " L "{\n"
+    "  #VE: " L "{#VE: 1; #VL: " L "y. 0; #VN: " L "lo. " L "hi. 0};\n"
+    "  #VL: " L "x. " L "{#VE: 0; #VL: " L "y. x == y; #VN: " L "lo. " L "hi. 0};\n"
+    "  #VN: " L "alo. " L "ahi. " L "{\n"
+    "    #VE: 0;\n"
+    "    #VL: " L "y. 0;\n"
+    "    #VN: " L "blo. " L "bhi. @v_eq(alo, blo) * @v_eq(ahi, bhi)\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "@mat_eq = " L "{\n"
+    "  #VE: " L "{#VE: 1; #VL: " L "y. 0; #VN: " L "lo. " L "hi. 0};\n"
+    "  #VL: " L "x. " L "{#VE: 0; #VL: " L "y. @v_eq(x, y); #VN: " L "lo. " L "hi. 0};\n"
+    "  #VN: " L "alo. " L "ahi. " L "{\n"
+    "    #VE: 0;\n"
+    "    #VL: " L "y. 0;\n"
+    "    #VN: " L "blo. " L "bhi. @mat_eq(alo, blo) * @mat_eq(ahi, bhi)\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "@v_list = " L "&n. " L "&key. " L "&stride. " L "{\n"
+    "  #VE: @v_inf_run(n, key, stride);\n"
+    "  #VL: " L "x. " L "{0: []; " L "k. [x]}(key < n);\n"
+    "  #VN: " L "lo. " L "hi. ! &s2 = stride * 2;\n"
+    "    @v_weave(@v_list(n, key, s2, lo), @v_list(n, key + stride, s2, hi))\n"
+    "}\n"
+    "\n"
+    "// Only padding rows are empty: every real row holds its 0 diagonal.\n"
+    "@mat_list = " L "&n. " L "&key. " L "&stride. " L "{\n"
+    "  #VE: [];\n"
+    "  #VL: " L "row. " L "{0: []; " L "k. [@v_list(n, 0, 1, row)]}(key < n);\n"
+    "  #VN: " L "lo. " L "hi. ! &s2 = stride * 2;\n"
+    "    @v_weave(@mat_list(n, key, s2, lo), @mat_list(n, key + stride, s2, hi))\n"
+    "}\n";
+
+static const char *APSP_TILE_DEFS =
+    "@b_min = " L "{\n"
+    "  #BE: " L "b. b;\n"
+    "  #BL: " L "&x. " L "{\n"
+    "    #BE: #BL{x};\n"
+    "    #BL: " L "&y. #BL{" L "{0: y; " L "c. x}(x < y)};\n"
+    "    #BN: " L "b0. " L "b1. " L "b2. " L "b3. #BE{}\n"
+    "  };\n"
+    "  #BN: " L "&a0. " L "&a1. " L "&a2. " L "&a3. " L "{\n"
+    "    #BE: #BN{a0, a1, a2, a3};\n"
+    "    #BL: " L "y. #BE{};\n"
+    "    #BN: " L "b0. " L "b1. " L "b2. " L "b3.\n"
+    "      #BN{@b_min(a0, b0), @b_min(a1, b1), @b_min(a2, b2), @b_min(a3, b3)}\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "@b_mul = " L "{\n"
+    "  #BE: " L "b. #BE{};\n"
+    "  #BL: " L "x. " L "{#BE: #BE{}; #BL: " L "y. #BL{x + y}; #BN: " L "b0. " L "b1. " L "b2. " L "b3. #BE{}};\n"
+    "  #BN: " L "&a0. " L "&a1. " L "&a2. " L "&a3. " L "{\n"
+    "    #BE: #BE{};\n"
+    "    #BL: " L "y. #BE{};\n"
+    "    #BN: " L "&b0. " L "&b1. " L "&b2. " L "&b3. #BN{\n"
+    "      @b_min(@b_mul(a0, b0), @b_mul(a1, b2)),\n"
+    "      @b_min(@b_mul(a0, b1), @b_mul(a1, b3)),\n"
+    "      @b_min(@b_mul(a2, b0), @b_mul(a3, b2)),\n"
+    "      @b_min(@b_mul(a2, b1), @b_mul(a3, b3))}\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "@mat_mul = " L "a. " L "b. @b_mul(a, b)\n"
+    "\n"
+    "@mat_eq = " L "{\n"
+    "  #BE: " L "{#BE: 1; #BL: " L "y. 0; #BN: " L "b0. " L "b1. " L "b2. " L "b3. 0};\n"
+    "  #BL: " L "x. " L "{#BE: 0; #BL: " L "y. x == y; #BN: " L "b0. " L "b1. " L "b2. " L "b3. 0};\n"
+    "  #BN: " L "a0. " L "a1. " L "a2. " L "a3. " L "{\n"
+    "    #BE: 0;\n"
+    "    #BL: " L "y. 0;\n"
+    "    #BN: " L "b0. " L "b1. " L "b2. " L "b3.\n"
+    "      @mat_eq(a0, b0) * @mat_eq(a1, b1) * @mat_eq(a2, b2) * @mat_eq(a3, b3)\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// Row i, columns key, key + stride, ..: follows i's bits down the\n"
+    "// row side and weaves the two column halves back together.\n"
+    "@b_row = " L "&n. " L "&i. " L "&key. " L "&stride. " L "{\n"
+    "  #BE: @v_inf_run(n, key, stride);\n"
+    "  #BL: " L "x. " L "{0: []; " L "k. [x]}(key < n);\n"
+    "  #BN: " L "a0. " L "a1. " L "a2. " L "a3. ! &s2 = stride * 2; ! &h = i / 2; " L "{\n"
+    "    0: @v_weave(@b_row(n, h, key, s2, a0), @b_row(n, h, key + stride, s2, a1));\n"
+    "    " L "o. @v_weave(@b_row(n, h, key, s2, a2), @b_row(n, h, key + stride, s2, a3))\n"
+    "  }(i % 2)\n"
+    "}\n"
+    "\n"
+    "@b_list = " L "&n. " L "&i. " L "&m. " L "{\n"
+    "  0: [];\n"
+    "  " L "k. @b_row(n, i, 0, 1, m) <> @b_list(n, i + 1, m)\n"
+    "}(i < n)\n";
+
+static const char *APSP_SQUARE_DEFS =
+    "@v_inf_run = " L "&n. " L "&key. " L "&stride. " L "{\n"
+    "  0: [];\n"
+    "  " L "k. @INF <> @v_inf_run(n, key + stride, stride)\n"
+    "}(key < n)\n"
+    "\n"
+    "@v_weave = " L "{[]: " L "b. []; <>: " L "h. " L "t. " L "b. h <> @v_weave(b, t)}\n"
+    "\n"
+    "@sq_check = " L "m. " L "&m2. " L "r. " L "{0: @sq_loop(m2, r); " L "e. m2}(@mat_eq(m, m2))\n";
+
+static const char *APSP_LOOP_DEFS =
+    "@sq_loop = " L "&m. " L "{0: m; " L "r. @sq_check(m, @mat_mul(m, m), r - 1)}\n";
+
+static const char *APSP_LOOP_GC_DEFS =
+    "@sq_loop = " L "&m. " L "{0: m; " L "r. @sq_step(%gc_poll(m), m, r - 1)}\n"
+    "@sq_step = " L "{\n"
+    "  0: " L "&m. " L "r. @sq_check(m, @mat_mul(m, m), r);\n"
+    "  " L "c. " L "m. " L "r. ! &k = %gc_done(%compact(m)); @sq_check(k, @mat_mul(k, k), r)\n"
+    "}\n";
+
+typedef struct { uint32_t row, col, w; } mat_entry_t;
+
+static uint32_t ceil_log2(uint32_t n) {
+  uint32_t r = 0;
+  while (n > 1) { r++; n = (n + 1) / 2; }
+  return r ? r : 1;
+}
+
+static size_t split(mat_entry_t *e, size_t len, int by_row, uint32_t stride) {
+  size_t lo = 0;
+  for (size_t i = 0; i < len; i++) {
+    uint32_t idx = by_row ? e[i].row : e[i].col;
+    if ((idx / stride) % 2 == 0) {
+      mat_entry_t t = e[lo]; e[lo] = e[i]; e[i] = t;
+      lo++;
+    }
+  }
+  return lo;
+}
+
+static uint32_t min_w(const mat_entry_t *e, size_t len) {
+  uint32_t w = 999999;
+  for (size_t i = 0; i < len; i++) if (e[i].w < w) w = e[i].w;
+  return w;
+}
+
+static void emit_vec(sbuf_t *sb, mat_entry_t *e, size_t len, uint32_t stride, uint32_t depth) {
+  if (len == 0) { sb_puts(sb, "#VE{}"); return; }
+  if (depth == 0) { sb_putu(sb, "#VL{%u}", min_w(e, len)); return; }
+  size_t lo = split(e, len, 0, stride);
+  sb_puts(sb, "#VN{");
+  emit_vec(sb, e, lo, stride * 2, depth - 1);
+  sb_puts(sb, ",");
+  emit_vec(sb, e + lo, len - lo, stride * 2, depth - 1);
+  sb_puts(sb, "}");
+}
+
+static void emit_rows(sbuf_t *sb, mat_entry_t *e, size_t len, uint32_t stride,
+                      uint32_t depth, uint32_t col_depth) {
+  if (len == 0) { sb_puts(sb, "#VE{}"); return; }
+  if (depth == 0) {
+    sb_puts(sb, "#VL{");
+    emit_vec(sb, e, len, 1, col_depth);
+    sb_puts(sb, "}");
+    return;
+  }
+  size_t lo = split(e, len, 1, stride);
+  sb_puts(sb, "#VN{");
+  emit_rows(sb, e, lo, stride * 2, depth - 1, col_depth);
+  sb_puts(sb, ",");
+  emit_rows(sb, e + lo, len - lo, stride * 2, depth - 1, col_depth);
+  sb_puts(sb, "}");
+}
+
+static void emit_quad(sbuf_t *sb, mat_entry_t *e, size_t len, uint32_t stride, uint32_t depth) {
+  if (len == 0) { sb_puts(sb, "#BE{}"); return; }
+  if (depth == 0) { sb_putu(sb, "#BL{%u}", min_w(e, len)); return; }
+  size_t r  = split(e, len, 1, stride);
+  size_t c0 = split(e, r, 0, stride);
+  size_t c1 = split(e + r, len - r, 0, stride);
+  size_t off[5] = { 0, c0, r, r + c1, len };
+  sb_puts(sb, "#BN{");
+  for (int q = 0; q < 4; q++) {
+    if (q > 0) sb_puts(sb, ",");
+    emit_quad(sb, e + off[q], off[q + 1] - off[q], stride * 2, depth - 1);
+  }
+  sb_puts(sb, "}");
+}
+
+static char *gen_hvm4_source(const graphgen_csr_t *g, int tiled) {
+  uint32_t n = g->n;
+  size_t len = (size_t)n + g->m;
+  mat_entry_t *e = malloc(len * sizeof(mat_entry_t));
+  size_t at = 0;
+  for (uint32_t u = 0; u < n; u++) {
+    e[at++] = (mat_entry_t){ u, u, 0 };
+    for (uint32_t k = g->row_ptr[u]; k < g->row_ptr[u + 1]; k++) {
+      e[at++] = (mat_entry_t){ u, g->col_idx[k], g->weight[k] };
+    }
+  }
+
+  sbuf_t sb = { 0 };
+  uint32_t depth = ceil_log2(n);
+  sb_puts(&sb, "@INF = 999999\n");
+  sb_putu(&sb, "@N = %u\n", n);
+  sb_puts(&sb, tiled ? APSP_TILE_DEFS : APSP_ROW_DEFS);
+  sb_puts(&sb, APSP_SQUARE_DEFS);
+  sb_puts(&sb, hvm4_gc_polling() ? APSP_LOOP_GC_DEFS : APSP_LOOP_DEFS);
+  sb_puts(&sb, "@D = ");
+  if (tiled) {
+    emit_quad(&sb, e, len, 1, depth);
+  } else {
+    emit_rows(&sb, e, len, 1, depth, depth);
+  }
+  sb_puts(&sb, "\n");
+  sb_putu(&sb, "@apsp = @sq_loop(@D, %u)\n", depth);
+  sb_puts(&sb, tiled ? "@main = @b_list(@N, 0, @apsp)\n"
+                     : "@main = @mat_list(@N, 0, 1, @apsp)\n");
+  free(e);
+  return sb.buf;
+}
+
+// ---------------------------------------------------------------------------
+// Reference and timing
+// ---------------------------------------------------------------------------
+
+static void fw_reference(const graphgen_csr_t *g, uint32_t *d) {
+  uint32_t n = g->n;
+  for (size_t i = 0; i < (size_t)n * n; i++) d[i] = 999999;
+  for (uint32_t u = 0; u < n; u++) {
+    d[(size_t)u * n + u] = 0;
+    for (uint32_t k = g->row_ptr[u]; k < g->row_ptr[u + 1]; k++) {
+      uint32_t *c = &d[(size_t)u * n + g->col_idx[k]];
+      if (g->weight[k] < *c) *c = g->weight[k];
+    }
+  }
+  for (uint32_t k = 0; k < n; k++)
+    for (uint32_t i = 0; i < n; i++)
+      for (uint32_t j = 0; j < n; j++) {
+        uint32_t s = d[(size_t)i * n + k] + d[(size_t)k * n + j];
+        if (s < d[(size_t)i * n + j]) d[(size_t)i * n + j] = s;
+      }
+}
+
+static double now_s(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// ---------------------------------------------------------------------------
+// Main
+// ---------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+  const char *pos[2]  = { "128,256,512,1024,2048", "8" };
+  int         npos    = 0;
+  const char *threads = "1";
+  int         tiled   = 0;
+  uint32_t    hvm_max = 1024;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--threads=", 10) == 0) {
+      threads = argv[i] + 10;
+    } else if (strcmp(argv[i], "--tiled") == 0) {
+      tiled = 1;
+    } else if (strncmp(argv[i], "--hvm-max=", 10) == 0) {
+      hvm_max = (uint32_t)atoi(argv[i] + 10);
+    } else if (npos < 2) {
+      pos[npos++] = argv[i];
+    }
+  }
+  uint32_t vs[SWEEP_MAX], ts[SWEEP_MAX];
+  int nv = sweep_parse_list(pos[0], vs, SWEEP_MAX);
+  int nt = sweep_parse_list(threads, ts, SWEEP_MAX);
+  uint32_t epn = (uint32_t)atoi(pos[1]);
+  if (nv == 0 || nt == 0) {
+    printf("usage: %s V1,V2,... [epn] [--threads=1,2,4,...] [--tiled] [--hvm-max=V]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%-6s %-8s %-14s %8s %12s  %s\n", "V", "E", "backend", "threads", "time (ms)", "check");
+  int all_ok = 1;
+  hvm4_lib_init();
+  for (int k = 0; k < nv; k++) {
+    uint32_t V = vs[k];
+    graphgen_csr_t g;
+    if (graphgen_geometric(&g, V, epn, 42 + V) != 0) return 1;
+    size_t cells = (size_t)V * V;
+    uint32_t *ref = malloc(cells * sizeof(uint32_t));
+    uint32_t *out = malloc(cells * sizeof(uint32_t));
+
+    // Native, one thread: the reference for everything else
+    double t0 = now_s();
+    int ok = apsp_native(g.row_ptr, g.col_idx, g.weight, V, ref, 1) == 0;
+    double secs = now_s() - t0;
+    if (ok && V <= 512) {
+      fw_reference(&g, out);
+      ok = memcmp(out, ref, cells * sizeof(uint32_t)) == 0;
+    }
+    printf("%-6u %-8u %-14s %8u %12.1f  %s\n", V, g.m, "native", 1, secs * 1e3,
+           ok ? (V <= 512 ? "PASS (FW)" : "ref") : "FAIL");
+    all_ok &= ok;
+
+    for (int j = 0; j < nt; j++) {
+      if (ts[j] == 1) continue;
+      t0 = now_s();
+      ok = apsp_native(g.row_ptr, g.col_idx, g.weight, V, out, ts[j]) == 0
+        && memcmp(out, ref, cells * sizeof(uint32_t)) == 0;
+      secs = now_s() - t0;
+      printf("%-6u %-8u %-14s %8u %12.1f  %s\n", V, g.m, "native", ts[j], secs * 1e3,
+             ok ? "PASS" : "FAIL");
+      all_ok &= ok;
+    }
+
+    if (V <= hvm_max) {
+      char *src = gen_hvm4_source(&g, tiled);
+      hvm4_lib_reset();
+      t0 = now_s();
+      int count = hvm4_run(src, 0, out, (int)cells);
+      secs = now_s() - t0;
+      ok = count == (int)cells && memcmp(out, ref, cells * sizeof(uint32_t)) == 0;
+      hvm4_stats_t st;
+      hvm4_stats(&st);
+      printf("%-6u %-8u %-14s %8u %12.1f  %s  (%lu itrs)\n", V, g.m,
+             tiled ? "hvm4 quadtree" : "hvm4 rows", hvm4_get_threads(), secs * 1e3,
+             ok ? "PASS" : "FAIL", (unsigned long)st.itrs);
+      all_ok &= ok;
+      free(src);
+    }
+
+    free(ref);
+    free(out);
+    graphgen_free(&g);
+  }
+  hvm4_lib_cleanup();
+  return all_ok ? 0 : 1;
+}
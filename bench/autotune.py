@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""Pick the fastest distance-trie radix per graph size and thread count.
+
+Usage: python3 bench/autotune.py [--sizes=100,256,1000,5000] [--epn=4]
+                                 [--threads=1,4] [--runs=3]
+                                 [--variants=bf_r2,bf_r4,bf_r8,bf_r16]
+                                 [--out=bench/trie_tuning.tsv]
+
+For every (V, threads) target it generates the library's Bellman-Ford
+program (gen.gen_radix_file: flat trie, V-1 rounds over the edge list) at
+radix 2, 4, 8 and 16 for the same graph (gen_graph(V, epn, seed 42 + V)),
+runs them through bench/hvm4_bench with HVM4_THREADS=threads, drops the
+ones that fail or return a wrong dist[V-1], and records the fastest (min
+over --runs) in a tab-separated decision table:
+
+  threads  v_max  edges  variant  radix  min_us  itrs
+
+lib/libhvm4_graph.c and c3lib/csrc/hvm4_bridge.c read that table at query
+time (HVM4_TRIE_TUNING=FILE, or hvm4_trie_tuning_load()): a graph with n
+nodes uses the row of the nearest measured thread count with the smallest
+v_max >= n (the largest v_max if n is bigger than every target). Only the
+radix is applied, so the candidates are exactly the programs the library
+emits and differ in nothing else. The other gen.py layouts (early
+termination, adjacency tries, radix 32, adaptive tries) change the round
+loop or the node shape the emitters build; compare them with
+./bench_trie.sh instead.
+
+Rows are keyed on V and threads, not on E: every candidate runs the same
+V-1 rounds over the same E edges with two lookups and at most one update
+per edge, so E scales all of them alike and the radix trades trie depth
+(log_r V) against node width (r), both functions of V. The edges column
+records the measured graph; tune at the --epn of your workload.
+
+The files are written to a temporary directory, so bench/ stays clean.
+"""
+import csv, io, os, subprocess, sys, tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(SCRIPT_DIR)
+sys.path.insert(0, SCRIPT_DIR)
+
+import gen
+
+BENCH = os.path.join(SCRIPT_DIR, "hvm4_bench")
+
+# variant -> radix of the library layout (gen.gen_radix_file)
+VARIANTS = {"bf_r2": 2, "bf_r4": 4, "bf_r8": 8, "bf_r16": 16}
+
+DEFAULT_SIZES = [100, 256, 1000, 5000]
+
+def parse_list(arg, conv=int):
+    return [conv(x) for x in arg.split(",") if x]
+
+def build_bench():
+    src = os.path.join(SCRIPT_DIR, "hvm4_bench.c")
+    if os.path.exists(BENCH) and os.path.getmtime(BENCH) >= os.path.getmtime(src):
+        return
+    cc = os.environ.get("CC", "clang")
+    subprocess.run([cc, "-O2", "-o", BENCH, src, "-lpthread"], check=True)
+
+def run_variant(path, threads, runs):
+    """One hvm4_bench process: returns the CSV row as a dict, or None when
+    the evaluation failed (heap overflow aborts the process)."""
+    env = dict(os.environ, HVM4_THREADS=str(threads))
+    p = subprocess.run([BENCH, f"--runs={runs}", "--format=csv", path],
+                       cwd=ROOT, env=env, capture_output=True, text=True)
+    for row in csv.DictReader(io.StringIO(p.stdout)):
+        if row["file"] == path and row["min_us"]:
+            return row
+    return None
+
+def main():
+    sizes, epn, threads, runs = DEFAULT_SIZES, 4, [1], 3
+    variants = list(VARIANTS)
+    out = os.path.join(SCRIPT_DIR, "trie_tuning.tsv")
+    for a in sys.argv[1:]:
+        k, _, v = a.partition("=")
+        if k == "--sizes":
+            sizes = parse_list(v)
+        elif k == "--epn":
+            epn = int(v)
+        elif k == "--threads":
+            threads = parse_list(v)
+        elif k == "--runs":
+            runs = int(v)
+        elif k == "--variants":
+            variants = parse_list(v, str)
+        elif k == "--out":
+            out = v
+        else:
+            sys.exit(__doc__)
+    unknown = [v for v in variants if v not in VARIANTS]
+    if unknown:
+        sys.exit(f"unknown variant(s): {', '.join(unknown)} "
+                 f"(have: {', '.join(VARIANTS)})")
+
+    build_bench()
+    rows = []
+    with tempfile.TemporaryDirectory(prefix="autotune_") as tmp:
+        for n in sizes:
+            edges = gen.gen_graph(n, edges_per_node=epn, seed=42 + n)
+            dist = gen.bellman_ford_py(n, edges)
+            files = {}
+            for v in variants:
+                path = os.path.join(tmp, f"{v}_{n}.hvm4")
+                with open(path, "w") as f:
+                    f.write(gen.gen_radix_file(n, edges, dist, VARIANTS[v]))
+                files[v] = path
+            for t in threads:
+                best = None
+                print(f"V={n} E={len(edges)} threads={t}")
+                for v in variants:
+                    row = run_variant(files[v], t, runs)
+                    if row is None:
+                        print(f"  {v:14s} failed")
+                        continue
+                    if int(row["first"]) != dist[n - 1]:
+                        print(f"  {v:14s} wrong result {row['first']} "
+                              f"(expected {dist[n - 1]})")
+                        continue
+                    us = float(row["min_us"])
+                    print(f"  {v:14s} {us:12.1f} us  {row['itrs']:>12s} itrs")
+                    if best is None or us < best[1]:
+                        best = (v, us, row["itrs"])
+                if best is None:
+                    print("  no variant succeeded; target skipped")
+                    continue
+                v, us, itrs = best
+                print(f"  -> {v} (radix {VARIANTS[v]})")
+                rows.append((t, n, len(edges), v, VARIANTS[v], us, itrs))
+
+    rows.sort()
+    with open(out, "w") as f:
+        f.write("# Trie radix decision table written by bench/autotune.py\n")
+        f.write(f"# epn={epn} runs={runs} variants={','.join(variants)}\n")
+        f.write("# threads\tv_max\tedges\tvariant\tradix\tmin_us\titrs\n")
+        for t, n, e, v, r, us, itrs in rows:
+            f.write(f"{t}\t{n}\t{e}\t{v}\t{r}\t{us:.1f}\t{itrs}\n")
+    print(f"\nWrote {len(rows)} decisions to {out}")
+
+if __name__ == "__main__":
+    main()
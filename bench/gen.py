@@ -1,11 +1,20 @@
 #!/usr/bin/env python3
 """Generate Bellman-Ford benchmark HVM4 files for comparing
-assoc-list, radix-16 trie, and radix-32 trie at various graph sizes.
-
-Usage: python3 bench/gen.py
-Outputs: bench/bf_{assoc,trie16,trie32}_{N}.hvm4
+assoc-list, radix-16 trie, and radix-32 trie at various graph sizes,
+plus the linear early-termination tries (binary, radix-4, radix-8,
+bucketed leaves and the adaptive mixed-radix layouts).
+
+Usage: python3 bench/gen.py [--gc]
+Outputs: bench/bf_{assoc,trie16,trie16_par,trie32,btrie,btrie_et,q4_et,q4_adj_et,
+         r8_et,bkt8_et,bkt16_et,adapt_wn_et,adapt_nw_et}_{N}.hvm4, bench/ds_btrie_et_{N}.hvm4,
+         bench/dijk_{btrie,bq}_{N}.hvm4 (Dijkstra: leftist heap / bucket-trie queue)
+
+--gc  route every loop round through @gc_tick so the bridge's compaction
+      policy (HVM4_GC) applies. Needs the %gc_poll/%gc_done primitives of
+      c3lib/csrc/hvm4_bridge.c, so these files run through the C drivers,
+      not ./HVM4/clang/main. Written as <variant>_gc_<N>.hvm4.
 """
-import os, math
+import os, sys, math
 
 SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
 
@@ -17,6 +26,8 @@ def lcg(seed=42):
         s = (s * 1103515245 + 12345) & 0x7fffffff
         yield s
 
+# Mirrored bit-for-bit by graphgen_uniform() in bench/graphgen.c; the C
+# drivers and bench/graphgen (binary CSR, fast at 2^24 nodes) rely on that.
 def gen_graph(n, edges_per_node=4, seed=42):
     rng = lcg(seed)
     edges = []
@@ -219,6 +230,43 @@ TRIE16_FUNCS = r"""
 }(slot)
 """
 
+TRIE16_MIN_UPDATE = r"""
+@trie_min_update = λ&key. λ&val. λ&depth. λ{
+  #HL: λ&old. λ{0: #HL{old}; λn. #HL{val}}(val < old);
+  #HE: λ{
+    0: #HL{val};
+    λn.
+      ! &slot = key % 16;
+      ! &next = key / 16;
+      ! &nd = depth - 1;
+      ! &leaf = @trie_min_update(next, val, nd, #HE{});
+      @trie_set_slot(slot, leaf)
+  }(depth);
+  #H: λ&c0.λ&c1.λ&c2.λ&c3.λ&c4.λ&c5.λ&c6.λ&c7.λ&c8.λ&c9.λ&c10.λ&c11.λ&c12.λ&c13.λ&c14.λ&c15.
+    ! &slot = key % 16;
+    ! &next = key / 16;
+    ! &nd = depth - 1;
+    λ{
+      0:  #H{@trie_min_update(next,val,nd,c0),c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15};
+      1:  #H{c0,@trie_min_update(next,val,nd,c1),c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15};
+      2:  #H{c0,c1,@trie_min_update(next,val,nd,c2),c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15};
+      3:  #H{c0,c1,c2,@trie_min_update(next,val,nd,c3),c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15};
+      4:  #H{c0,c1,c2,c3,@trie_min_update(next,val,nd,c4),c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15};
+      5:  #H{c0,c1,c2,c3,c4,@trie_min_update(next,val,nd,c5),c6,c7,c8,c9,c10,c11,c12,c13,c14,c15};
+      6:  #H{c0,c1,c2,c3,c4,c5,@trie_min_update(next,val,nd,c6),c7,c8,c9,c10,c11,c12,c13,c14,c15};
+      7:  #H{c0,c1,c2,c3,c4,c5,c6,@trie_min_update(next,val,nd,c7),c8,c9,c10,c11,c12,c13,c14,c15};
+      8:  #H{c0,c1,c2,c3,c4,c5,c6,c7,@trie_min_update(next,val,nd,c8),c9,c10,c11,c12,c13,c14,c15};
+      9:  #H{c0,c1,c2,c3,c4,c5,c6,c7,c8,@trie_min_update(next,val,nd,c9),c10,c11,c12,c13,c14,c15};
+      10: #H{c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,@trie_min_update(next,val,nd,c10),c11,c12,c13,c14,c15};
+      11: #H{c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,@trie_min_update(next,val,nd,c11),c12,c13,c14,c15};
+      12: #H{c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,@trie_min_update(next,val,nd,c12),c13,c14,c15};
+      13: #H{c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,@trie_min_update(next,val,nd,c13),c14,c15};
+      14: #H{c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,@trie_min_update(next,val,nd,c14),c15};
+      λn. #H{c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,@trie_min_update(next,val,nd,c15)}
+    }(slot)
+}
+"""
+
 TRIE16_RELAX = r"""
 @relax_edge = λ&dist. λ{
   #E3: λ&u. λ&v. λw.
@@ -602,6 +650,28 @@ def gen_trie16_file(n, edges, dist):
 //{dist[n-1]}
 """
 
+def gen_trie16_par_file(n, edges, dist, parts):
+    depth = ceil_log(n, 16)
+    tree_str, largest = fmt_edge_tree(edges, parts)
+    append_func = APPEND_FUNC if largest > 3500 else ""
+
+    return f"""// Bellman-Ford SSSP — radix-16 trie, {parts} edge partitions merged per round + early termination — V={n}, E={len(edges)}, depth={depth}
+// Expected: dist[{n-1}] = {dist[n-1]}
+
+@INF = 999999
+@DEPTH = {depth}
+{append_func}{TRIE16_FUNCS}{TRIE16_MIN_UPDATE}
+{tree_str}
+{TRIE16_PAR}{REPEAT_UNTIL}
+@init_dist = @trie_set(0, 0, @DEPTH, #HE{{}})
+@init_state = #S{{@init_dist, 1}}
+
+@bf = @repeat_until(@relax_round_par, @init_state, {n-1})
+
+@main = λ{{#S: λdist. λc. @trie_get({n-1}, @DEPTH, dist)}}(@bf)
+//{dist[n-1]}
+"""
+
 def gen_trie32_file(n, edges, dist):
     depth = ceil_log(n, 32)
     edges_str = fmt_edges(edges)
@@ -838,6 +908,342 @@ Q4_ET_COMMON = r"""
 }
 """
 
+# ---------- Radix-R and adaptive linear tries (early termination) ----------
+#
+# linear_trie_funcs() writes the q4-style linear trie for any radix R
+# (2..16): nodes #C{c0, ..}, leaves #CL{val}, empties #CE{} and the
+# operations @p_get, @p_get_lin, @p_set, @p_min_update and
+# @p_min_update_f with the (key, depth, trie) signature of the others.
+# Every operation takes the trie apart and rebuilds it, so no trie node is
+# cloned; per-slot helpers keep each child in exactly one arm.
+#
+# bucket_trie_funcs() is the same trie with wide leaves #CK{v0..v(B-1)}
+# holding B consecutive keys (B <= 16, the constructor arity limit): the
+# levels split key / B, so depth and node count drop by log_R(B) levels.
+#
+# bulk_trie_funcs() adds the parallel fill and in-order flatten of
+# lib/_trie_lib_.hvm4 for such a trie (the r8 files start from a filled trie).
+#
+# adaptive_trie_funcs() puts @DEPTH levels of one radix on top of such a
+# trie of another radix (@LO_DEPTH levels). The top levels reuse the lower
+# trie's empty constructor, so a fresh sibling is valid at any level, and
+# at depth 0 each operation hands over to the lower trie.
+
+# ---------- Edge-partitioned relaxation (radix-16 trie) ----------
+#
+# The edges are split into `parts` lists laid out as a balanced tree of
+# #EN{left, right} / #EL{edges}. Each round relaxes every partition against
+# the same snapshot of the distances into a sparse update trie and reduces
+# them with @trie_min_merge (see lib/_trie_lib_.hvm4), so the partitions
+# are independent work for the HVM4 threads.
+
+TRIE16_PAR = r"""
+@trie_min_merge = λ{
+  #HE: λb. b;
+  #HL: λ&x. λ{
+    #HE: #HL{x};
+    #HL: λ&y. λ{0: #HL{y}; λn. #HL{x}}(x < y);
+    #H: λb0.λb1.λb2.λb3.λb4.λb5.λb6.λb7.λb8.λb9.λb10.λb11.λb12.λb13.λb14.λb15. #HL{x}
+  };
+  #H: λa0.λa1.λa2.λa3.λa4.λa5.λa6.λa7.λa8.λa9.λa10.λa11.λa12.λa13.λa14.λa15. λb.
+    @trie_min_merge_H(b, a0,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15)
+}
+
+// b's shape decides; a's children arrive as arguments, one use per arm
+@trie_min_merge_H = λ{
+  #HE: λa0.λa1.λa2.λa3.λa4.λa5.λa6.λa7.λa8.λa9.λa10.λa11.λa12.λa13.λa14.λa15. #H{a0,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15};
+  #HL: λy. λa0.λa1.λa2.λa3.λa4.λa5.λa6.λa7.λa8.λa9.λa10.λa11.λa12.λa13.λa14.λa15. #H{a0,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15};
+  #H: λb0.λb1.λb2.λb3.λb4.λb5.λb6.λb7.λb8.λb9.λb10.λb11.λb12.λb13.λb14.λb15. λa0.λa1.λa2.λa3.λa4.λa5.λa6.λa7.λa8.λa9.λa10.λa11.λa12.λa13.λa14.λa15.
+    #H{@trie_min_merge(a0,b0),@trie_min_merge(a1,b1),@trie_min_merge(a2,b2),@trie_min_merge(a3,b3),@trie_min_merge(a4,b4),@trie_min_merge(a5,b5),@trie_min_merge(a6,b6),@trie_min_merge(a7,b7),@trie_min_merge(a8,b8),@trie_min_merge(a9,b9),@trie_min_merge(a10,b10),@trie_min_merge(a11,b11),@trie_min_merge(a12,b12),@trie_min_merge(a13,b13),@trie_min_merge(a14,b14),@trie_min_merge(a15,b15)}
+}
+
+@trie_nonempty = λ{
+  #HE: 0;
+  #HL: λv. 1;
+  #H: λc0.λc1.λc2.λc3.λc4.λc5.λc6.λc7.λc8.λc9.λc10.λc11.λc12.λc13.λc14.λc15. 1
+}
+
+// Relax one edge against `snap`, recording an improvement in `acc`
+@relax_into = λ&snap. λ&acc. λ{
+  #E3: λ&u. λ&v. λw.
+    ! &new_d = @trie_get(u, @DEPTH, snap) + w;
+    λ{0: acc; λn. @trie_min_update(v, new_d, @DEPTH, acc)}(new_d < @trie_get(v, @DEPTH, snap))
+}
+
+@relax_part = λ&snap. λ&acc. λ{
+  []: acc;
+  <>: λh. λt. @relax_part(snap, @relax_into(snap, acc, h), t)
+}
+
+@relax_tree = λ&snap. λ{
+  #EL: λes. @relax_part(snap, #HE{}, es);
+  #EN: λl. λr. @trie_min_merge(@relax_tree(snap, l), @relax_tree(snap, r))
+}
+
+@relax_round_par = λ{
+  #S: λ&dist. λold_changed.
+    ! &upd = @relax_tree(dist, @edge_tree);
+    #S{@trie_min_merge(dist, upd), @trie_nonempty(upd)}
+}
+"""
+
+REPEAT_UNTIL = r"""
+@repeat_until = λf. λx. λn. @repeat_until_go(n, f, x)
+
+@repeat_until_go = λ{
+  0: λf. λx. x;
+  λn. λ&f. λstate.
+    @check_continue(n, f, f(state))
+}
+
+@check_continue = λ&n. λ&f. λ{
+  #S: λdist. λchanged.
+    @check_go(changed, n, f, dist)
+}
+
+@check_go = λ{
+  0: λn. λf. λdist. #S{dist, 0};
+  λm. λn. λf. λdist. @repeat_until_go(n - 1, f, #S{dist, 1})
+}
+"""
+
+def fmt_edge_tree(edges, parts):
+    """@part_i lists plus @edge_tree, the balanced #EN/#EL tree over them."""
+    parts = max(1, min(parts, len(edges)))
+    size = -(-len(edges) // parts)
+    chunks = [edges[i:i + size] for i in range(0, len(edges), size)]
+    defs = [fmt_edge_list(c, f"part_{i}") for i, c in enumerate(chunks)]
+
+    def tree(lo, hi):
+        if hi - lo == 1:
+            return f"#EL{{@part_{lo}}}"
+        mid = (lo + hi) // 2
+        return f"#EN{{{tree(lo, mid)}, {tree(mid, hi)}}}"
+
+    defs.append(f"@edge_tree = {tree(0, len(chunks))}")
+    return "\n\n".join(defs), max(len(c) for c in chunks)
+
+def _kids(r):
+    return ", ".join(f"c{i}" for i in range(r))
+
+def _lams(r):
+    return " ".join(f"λc{i}." for i in range(r))
+
+def _node(ctor, r, i, child, other=None):
+    kids = [child if j == i else (other or f"c{j}") for j in range(r)]
+    return f"#{ctor}{{{', '.join(kids)}}}"
+
+def _slot_arms(name, r, arm):
+    """@name = λ{0: ..; 1: ..; λn. ..}, one arm per slot."""
+    arms = [f"  {i}: {arm(i)};" for i in range(r - 1)]
+    arms.append(f"  λn. {arm(r - 1)}")
+    return f"@{name} = λ{{\n" + "\n".join(arms) + "\n}\n"
+
+def _split(r, ind, b=1):
+    """Consume one radix-r digit of the key. With leaf blocks of b values
+    the digit sits above the in-block offset key % b, which is kept in the
+    low part of `next` so it reaches the leaf."""
+    if b == 1:
+        return (f"{ind}! slot = key % {r};\n"
+                f"{ind}! next = key / {r};\n"
+                f"{ind}! nd = depth - 1;\n")
+    return (f"{ind}! slot = key / {b} % {r};\n"
+            f"{ind}! next = key / {b * r} * {b} + key % {b};\n"
+            f"{ind}! nd = depth - 1;\n")
+
+def _descend_ops(p, C, E, r, leaves=None, fresh=None, b=1):
+    """The get_lin/get/set/min_update/min_update_f bodies for `#C` nodes
+    with `#E` empties. leaves[op] is the op's leaf arm and fresh[op] what
+    it builds at depth 0 (linear trie); the adaptive top has neither.
+    b > 1 splits keys for leaves holding blocks of b values."""
+    kids, lams = _kids(r), _lams(r)
+    out = []
+
+    def head(op, params, empty_arm, slot_call):
+        arms = []
+        if leaves:
+            arms.append(f"  {leaves[op]};")
+        arms.append(f"  #{E}:{'' if empty_arm.startswith(chr(10)) else ' '}{empty_arm};")
+        arms.append(f"  #{C}: {lams}\n{_split(r, '    ', b)}    {slot_call}")
+        return f"@{p}_{op} = {' '.join(f'λ&{x}.' for x in params)} λ{{\n" \
+               + "\n".join(arms) + "\n}\n"
+
+    def empty_path(op, helper):
+        if fresh:
+            return (f"λ{{\n    0: {fresh[op]};\n    λn.\n"
+                    f"{_split(r, '      ', b)}      @{helper}(slot, next, val, nd)\n"
+                    f"  }}(depth)")
+        return "\n" + _split(r, "    ", b)[:-1] + f"\n    @{helper}(slot, next, val, nd)"
+
+    # get_lin: #P{val, rebuilt trie}
+    out.append(head("get_lin", ("key", "depth"), f"#P{{@INF, #{E}{{}}}}",
+                    f"@{p}_get_lin_{C}(slot, next, nd, {kids})"))
+    out.append(_slot_arms(f"{p}_get_lin_{C}", r, lambda i:
+        f"λnext. λnd. {lams}\n"
+        f"    λ{{#P: λval. λnew_c{i}. #P{{val, {_node(C, r, i, f'new_c{i}')}}}}}"
+        f"(@{p}_get_lin(next, nd, c{i}))"))
+
+    # get: destructive, for the final extraction
+    out.append(head("get", ("key", "depth"), "@INF",
+                    f"@{p}_get_{C}(slot, next, nd, {kids})"))
+    out.append(_slot_arms(f"{p}_get_{C}", r, lambda i:
+        f"λnext. λnd. {lams} @{p}_get(next, nd, c{i})"))
+
+    # set / min_update: build the path through empties
+    for op, short in [("set", "set"), ("min_update", "mu")]:
+        out.append(head(op, ("key", "val", "depth"),
+                        empty_path(op, f"{p}_{short}_{E}"),
+                        f"@{p}_{short}_{C}(slot, next, val, nd, {kids})"))
+        out.append(_slot_arms(f"{p}_{short}_{E}", r, lambda i:
+            "λnext. λval. λnd. "
+            + _node(C, r, i, f"@{p}_{op}(next, val, nd, #{E}{{}})", f"#{E}{{}}")))
+        out.append(_slot_arms(f"{p}_{short}_{C}", r, lambda i:
+            f"λnext. λval. λnd. {lams} "
+            + _node(C, r, i, f"@{p}_{op}(next, val, nd, c{i})")))
+
+    # min_update_f: #P{new trie, 1 if changed else 0}
+    out.append(head("min_update_f", ("key", "val", "depth"),
+                    empty_path("min_update_f", f"{p}_muf_{E}"),
+                    f"@{p}_muf_{C}(slot, next, val, nd, {kids})"))
+    out.append(_slot_arms(f"{p}_muf_{E}", r, lambda i:
+        "λnext. λval. λnd.\n"
+        f"    λ{{#P: λchild. λc. #P{{{_node(C, r, i, 'child', f'#{E}{{}}')}, c}}}}"
+        f"(@{p}_min_update_f(next, val, nd, #{E}{{}}))"))
+    out.append(_slot_arms(f"{p}_muf_{C}", r, lambda i:
+        f"λnext. λval. λnd. {lams}\n"
+        f"    λ{{#P: λnew_c{i}. λc. #P{{{_node(C, r, i, f'new_c{i}')}, c}}}}"
+        f"(@{p}_min_update_f(next, val, nd, c{i}))"))
+    return out
+
+def linear_trie_funcs(p, ctor, r):
+    L, E = ctor + "L", ctor + "E"
+    leaves = {
+        "get_lin":      f"#{L}: λ&val. #P{{val, #{L}{{val}}}}",
+        "get":          f"#{L}: λval. val",
+        "set":          f"#{L}: λold. #{L}{{val}}",
+        "min_update":   f"#{L}: λ&old. λ{{0: #{L}{{old}}; λn. #{L}{{val}}}}(val < old)",
+        "min_update_f": f"#{L}: λ&old. λ{{0: #P{{#{L}{{old}}, 0}}; λn. #P{{#{L}{{val}}, 1}}}}(val < old)",
+    }
+    fresh = {"set": f"#{L}{{val}}", "min_update": f"#{L}{{val}}",
+             "min_update_f": f"#P{{#{L}{{val}}, 1}}"}
+    return "\n" + "\n".join(_descend_ops(p, ctor, E, r, leaves, fresh))
+
+def bulk_trie_funcs(p, ctor, r):
+    """@p_fill_n(n, depth, val) and @p_to_list(n, depth, trie) for the
+    linear trie @p_* (see @trie_fill_n / @trie_to_list in
+    lib/_trie_lib_.hvm4): one parallel O(V) build of keys 0..n-1 and an
+    in-order flatten whose children are reduced independently."""
+    L, E = ctor + "L", ctor + "E"
+    offs = [f"key + stride * {i}" for i in range(r)]
+    fill = ",\n      ".join(f"@{p}_fill_go(n, {o}, s2, nd, val)" for o in offs)
+    flat = ",\n      ".join(f"@{p}_to_list_go(n, {o}, s2, nd, c{i})"
+                           for i, o in enumerate(offs))
+    rest = " ".join(f"λc{i}." for i in range(1, r))
+    return f"""
+@{p}_fill_n = λn. λdepth. λval. @{p}_fill_go(n, 0, 1, depth, val)
+
+@{p}_fill_go = λ&n. λ&key. λ&stride. λ&depth. λ&val. λ{{
+  0: #{E}{{}};
+  λk. λ{{
+    0: #{L}{{val}};
+    λd.
+      ! &nd = depth - 1;
+      ! &s2 = stride * {r};
+      #{ctor}{{
+      {fill}}}
+  }}(depth)
+}}(key < n)
+
+@{p}_to_list = λn. λdepth. λtrie. @{p}_to_list_go(n, 0, 1, depth, trie)
+
+@{p}_to_list_go = λ&n. λ&key. λ&stride. λ&depth. λ{{
+  #{E}: @{p}_inf_run(n, key, stride);
+  #{L}: λval. λ{{0: []; λk. [val]}}(key < n);
+  #{ctor}: {_lams(r)}
+    ! &nd = depth - 1;
+    ! &s2 = stride * {r};
+    @{p}_weave(
+      {flat})
+}}
+
+@{p}_inf_run = λ&n. λ&key. λ&stride. λ{{
+  0: [];
+  λk. @INF <> @{p}_inf_run(n, key + stride, stride)
+}}(key < n)
+
+@{p}_weave = λ{{
+  []: {rest} [];
+  <>: λh. λt. {rest} h <> @{p}_weave({", ".join(f"c{i}" for i in range(1, r))}, t)
+}}
+"""
+
+def bucket_trie_funcs(p, ctor, r, b):
+    """Linear radix-r trie whose leaves #ctorK{v0..v(b-1)} hold a block of
+    b consecutive keys, so a dense 0..V-1 keyspace needs log_r(V / b)
+    levels and V / b leaves. An operation rebuilds its path and the one
+    block; the @p_k* helpers switch on the in-block offset."""
+    K, E = ctor + "K", ctor + "E"
+    vals = ", ".join(f"v{i}" for i in range(b))
+    vlams = " ".join(f"λv{i}." for i in range(b))
+    infs = ", ".join(["@INF"] * b)
+
+    def vl(i):
+        return " ".join(f"λ&v{j}." if j == i else f"λv{j}." for j in range(b))
+
+    def blk(i, x):
+        return f"#{K}{{{', '.join(x if j == i else f'v{j}' for j in range(b))}}}"
+
+    leaves = {
+        "get_lin":      f"#{K}: {vlams} @{p}_kget_lin(key, {vals})",
+        "get":          f"#{K}: {vlams} @{p}_kget(key, {vals})",
+        "set":          f"#{K}: {vlams} @{p}_kset(key, val, {vals})",
+        "min_update":   f"#{K}: {vlams} @{p}_kmu(key, val, {vals})",
+        "min_update_f": f"#{K}: {vlams} @{p}_kmuf(key, val, {vals})",
+    }
+    fresh = {"set":          f"@{p}_kset(key, val, {infs})",
+             "min_update":   f"@{p}_kmu(key, val, {infs})",
+             "min_update_f": f"@{p}_kmuf(key, val, {infs})"}
+    out = _descend_ops(p, ctor, E, r, leaves, fresh, b)
+    out.append(_slot_arms(f"{p}_kget_lin", b, lambda i:
+        f"{vl(i)} #P{{v{i}, #{K}{{{vals}}}}}"))
+    out.append(_slot_arms(f"{p}_kget", b, lambda i: f"{vlams} v{i}"))
+    out.append(_slot_arms(f"{p}_kset", b, lambda i:
+        f"λval. {vlams} {blk(i, 'val')}"))
+    out.append(_slot_arms(f"{p}_kmu", b, lambda i:
+        f"λ&val. {vl(i)} {blk(i, f'λ{{0: v{i}; λn. val}}(val < v{i})')}"))
+    out.append(_slot_arms(f"{p}_kmuf", b, lambda i:
+        f"λ&val. {vl(i)}\n    ! &c = val < v{i};\n"
+        f"    #P{{{blk(i, f'λ{{0: v{i}; λn. val}}(c)')}, c}}"))
+    return "\n" + "\n".join(out)
+
+def adaptive_trie_funcs(p, ctor, r, lo, lo_empty):
+    """Top levels @p_* (#ctor, radix r) over the linear trie @lo_*."""
+    out = [f"""@{p}_get_lin = λ&key. λ{{
+  0: λt. @{lo}_get_lin(key, @LO_DEPTH, t);
+  λd. λt. @{p}_get_lin_N(key, d, t)
+}}
+""", f"""@{p}_get = λ&key. λ{{
+  0: λt. @{lo}_get(key, @LO_DEPTH, t);
+  λd. λt. @{p}_get_N(key, d, t)
+}}
+"""]
+    for op in ("set", "min_update", "min_update_f"):
+        out.append(f"""@{p}_{op} = λ&key. λ&val. λ{{
+  0: λt. @{lo}_{op}(key, val, @LO_DEPTH, t);
+  λd. λt. @{p}_{op}_N(key, val, d, t)
+}}
+""")
+    # The per-level bodies are the linear ones with the recursion
+    # re-entering @p_op (which dispatches on depth) and no leaf arm.
+    body = _descend_ops(p, ctor, lo_empty, r)
+    for op in ("get_lin", "get", "set", "min_update", "min_update_f"):
+        body = [b.replace(f"@{p}_{op} = ", f"@{p}_{op}_N = ", 1) for b in body]
+    return "\n" + "\n".join(out + body)
+
+def radix_et_relax(p):
+    """Q4_ET_RELAX for the linear trie @p_*."""
+    return Q4_ET_RELAX.replace("@q4_", f"@{p}_")
+
 DELTA_STEP_ET_ROUND = r"""
 @one_round_et = λ{#S: λdist. λold_changed.
   @one_round_et_2(@foldl_et(@relax_edge_et, #S{dist, 0}, @light_edges))
@@ -1064,6 +1470,178 @@ def gen_q4_adj_et_file(n, edges, dist):
 //{dist[n-1]}
 """
 
+def gen_r8_et_file(n, edges, dist):
+    depth = ceil_log(n, 8)
+    edges_str = fmt_edges(edges)
+    needs_append = len(edges) > 3500
+    append_func = APPEND_FUNC if needs_append else ""
+
+    return f"""// Bellman-Ford SSSP — linear radix-8 trie + early termination — V={n}, E={len(edges)}, depth={depth}
+// Expected: dist[{n-1}] = {dist[n-1]}
+
+@INF = 999999
+@DEPTH = {depth}
+{append_func}{linear_trie_funcs("r8", "O", 8)}
+{bulk_trie_funcs("r8", "O", 8)}
+{edges_str}
+{radix_et_relax("r8")}
+{Q4_ET_COMMON}
+@init_dist = @r8_set(0, 0, @DEPTH, @r8_fill_n({n}, @DEPTH, @INF))
+@init_state = #S{{@init_dist, 1}}
+
+@bf = @repeat_until(@relax_round_et, @init_state, {n-1})
+
+@extract = λ{{#S: λdist. λc.
+  @r8_get({n-1}, @DEPTH, dist)
+}}
+
+@main = @extract(@bf)
+//{dist[n-1]}
+"""
+
+def radix_trie_funcs(r):
+    """@q_get / @q_set / @q_set_slot / @q_fill_n for a flat radix-r trie
+    (#Q / #QE / #QL), the layout lib/libhvm4_graph.c (gen_trie_ops) and
+    the C3 emitter (emit_trie_defs) build for bellman_ford."""
+    last = r - 1
+    def node(slot, at, fresh):
+        kids = [at.format(i) if i == slot else "#QE{}" if fresh else f"c{i}"
+                for i in range(r)]
+        return "#Q{" + ",".join(kids) + "}"
+    def arms(body):
+        return "; ".join(f"{i}: {body(i)}" for i in range(last)) \
+            + f"; λn. {body(last)}"
+    lams = " ".join(f"λ&c{i}." for i in range(r))
+    step = f"! &slot = key % {r}; ! &next = key / {r}; ! &nd = depth - 1;"
+    fill = ",".join(f"@q_fill_go(n,key + stride * {i},s2,nd,val)"
+                    for i in range(r))
+    return f"""
+@q_get = λ&key. λ&depth. λ{{
+  #QE: @INF;
+  #QL: λval. val;
+  #Q: {lams}
+    {step}
+    λ{{{arms(lambda i: f"@q_get(next,nd,c{i})")}}}(slot)
+}}
+
+@q_set = λ&key. λ&val. λ&depth. λ{{
+  #QL: λold. #QL{{val}};
+  #QE: λ{{0: #QL{{val}}; λn.
+    {step}
+    @q_set_slot(slot, @q_set(next, val, nd, #QE{{}}))}}(depth);
+  #Q: {lams}
+    {step}
+    λ{{{arms(lambda i: node(i, "@q_set(next,val,nd,c{})", False))}}}(slot)
+}}
+
+@q_set_slot = λ&slot. λ&child. λ{{{arms(lambda i: node(i, "child", True))}}}(slot)
+
+@q_fill_n = λn. λdepth. λval. @q_fill_go(n, 0, 1, depth, val)
+@q_fill_go = λ&n. λ&key. λ&stride. λ&depth. λ&val. λ{{0: #QE{{}}; λk.
+  λ{{0: #QL{{val}}; λd.
+    ! &nd = depth - 1; ! &s2 = stride * {r};
+    #Q{{{fill}}}}}(depth)}}(key < n)
+"""
+
+RADIX_RELAX = r"""
+@relax_edge = λ&dist. λ{
+  #E3: λ&u. λ&v. λw.
+    ! &du = @q_get(u, @DEPTH, dist);
+    ! &new_d = du + w;
+    ! &dv = @q_get(v, @DEPTH, dist);
+    λ{0: dist; λn. @q_set(v, new_d, @DEPTH, dist)}(new_d < dv)
+}
+"""
+
+def gen_radix_file(n, edges, dist, radix):
+    """The program hvm4_shortest_path / bellman_ford emit for this graph:
+    a flat radix-`radix` trie filled with @INF, V-1 lazy @repeat rounds
+    over the edge list. bench/autotune.py times these, so its decision
+    table only ever names a layout the library can actually build."""
+    depth = ceil_log(n, radix)
+    edges_str = fmt_edges(edges)
+    needs_append = len(edges) > 3500
+    append_func = APPEND_FUNC if needs_append else ""
+
+    return f"""// Bellman-Ford SSSP — library layout, flat radix-{radix} trie — V={n}, E={len(edges)}, depth={depth}
+// Expected: dist[{n-1}] = {dist[n-1]}
+
+@INF = 999999
+@DEPTH = {depth}
+{append_func}{radix_trie_funcs(radix)}
+{edges_str}
+{RADIX_RELAX}
+{COMMON_FUNCS}
+@init_dist = @q_set(0, 0, @DEPTH, @q_fill_n({n}, @DEPTH, @INF))
+
+@bf = @repeat(@relax_round, @init_dist, {n-1})
+
+@main = @q_get({n-1}, @DEPTH, @bf)
+//{dist[n-1]}
+"""
+
+def gen_bucket_et_file(n, edges, dist, radix, block):
+    """Radix-`radix` linear trie with `block` distances per leaf."""
+    depth = ceil_log(-(-n // block), radix)
+    edges_str = fmt_edges(edges)
+    needs_append = len(edges) > 3500
+    append_func = APPEND_FUNC if needs_append else ""
+
+    return f"""// Bellman-Ford SSSP — bucketed-leaf trie (radix-{radix}, {block} values per leaf) + early termination — V={n}, E={len(edges)}, depth={depth}
+// Expected: dist[{n-1}] = {dist[n-1]}
+
+@INF = 999999
+@DEPTH = {depth}
+{append_func}{bucket_trie_funcs("bk", "G", radix, block)}
+{edges_str}
+{radix_et_relax("bk")}
+{Q4_ET_COMMON}
+@init_dist = @bk_set(0, 0, @DEPTH, #GE{{}})
+@init_state = #S{{@init_dist, 1}}
+
+@bf = @repeat_until(@relax_round_et, @init_state, {n-1})
+
+@extract = λ{{#S: λdist. λc.
+  @bk_get({n-1}, @DEPTH, dist)
+}}
+
+@main = @extract(@bf)
+//{dist[n-1]}
+"""
+
+def gen_adaptive_et_file(n, edges, dist, top_radix, top_depth, lo_radix):
+    """`top_depth` radix-`top_radix` levels over a radix-`lo_radix` linear
+    trie. The top levels consume the low digits of the key, so the lower
+    trie indexes key / top_radix^top_depth."""
+    lo_depth = ceil_log(-(-n // top_radix ** top_depth), lo_radix)
+    edges_str = fmt_edges(edges)
+    needs_append = len(edges) > 3500
+    append_func = APPEND_FUNC if needs_append else ""
+
+    return f"""// Bellman-Ford SSSP — adaptive trie (radix-{top_radix} x{top_depth} over radix-{lo_radix} x{lo_depth}) + early termination — V={n}, E={len(edges)}, depth={top_depth + lo_depth}
+// Expected: dist[{n-1}] = {dist[n-1]}
+
+@INF = 999999
+@DEPTH = {top_depth}
+@LO_DEPTH = {lo_depth}
+{append_func}{linear_trie_funcs("lo", "D", lo_radix)}
+{adaptive_trie_funcs("ad", "A", top_radix, "lo", "DE")}
+{edges_str}
+{radix_et_relax("ad")}
+{Q4_ET_COMMON}
+@init_dist = @ad_set(0, 0, @DEPTH, #DE{{}})
+@init_state = #S{{@init_dist, 1}}
+
+@bf = @repeat_until(@relax_round_et, @init_state, {n-1})
+
+@extract = λ{{#S: λdist. λc.
+  @ad_get({n-1}, @DEPTH, dist)
+}}
+
+@main = @extract(@bf)
+//{dist[n-1]}
+"""
+
 def gen_delta_step_et_file(n, edges, dist, delta):
     depth = ceil_log(n, 2)
     light = [(u,v,w) for u,v,w in edges if w <= delta]
@@ -1100,6 +1678,295 @@ def gen_delta_step_et_file(n, edges, dist, delta):
 //{dist[n-1]}
 """
 
+# ---------- Dijkstra (binary trie + priority queue) ----------
+
+PQ_LEFTIST = r"""
+@pq_empty = #PQE{}
+
+@pq_rank = λ{
+  #PQE: 0;
+  #PQN: λp.λv.λl.λr.λk. k
+}
+
+@pq_make = λ&prio.λ&val.λ&left.λ&right.
+  ! &lr = @pq_rank(left)
+  ! &rr = @pq_rank(right)
+  λ{0:
+    #PQN{prio, val, right, left, lr + 1};
+  λn.
+    #PQN{prio, val, left, right, rr + 1}
+  }(lr >= rr)
+
+@pq_merge = λ{
+  #PQE: λb. b;
+  #PQN: λ&ap.λ&av.λ&al.λ&ar.λ&ak. λ{
+    #PQE: #PQN{ap, av, al, ar, ak};
+    #PQN: λ&bp.λ&bv.λ&bl.λ&br.λ&bk.
+      λ{0:
+        @pq_make(bp, bv, bl, @pq_merge(#PQN{ap, av, al, ar, ak}, br));
+      λn.
+        @pq_make(ap, av, al, @pq_merge(ar, #PQN{bp, bv, bl, br, bk}))
+      }(ap <= bp)
+  }
+}
+
+@pq_insert = λprio.λval.λheap.
+  @pq_merge(#PQN{prio, val, #PQE{}, #PQE{}, 1}, heap)
+
+@pq_pop = λ{
+  #PQE: #PQE{};
+  #PQN: λp.λv.λl.λr.λk. #R{p, v, @pq_merge(l, r)}
+}
+"""
+
+# Bucket queue over an MSB-first binary trie of priorities
+# (lib/_pq_bucket_lib_.hvm4); needs @PQ_HALF.
+PQ_BUCKET = r"""
+@pq_empty = #KE{}
+
+@pq_is_empty = λ{
+  #KE: 1;
+  #KN: λlo.λhi. 0;
+  #KB: λvals. 0
+}
+
+@pq_insert = λprio.λval.λheap.
+  @pq_ins(prio, val, @PQ_HALF, heap)
+
+@pq_ins = λ&prio.λ&val.λ&half. λ{
+  #KE: λ{
+    0: #KB{[val]};
+    λh. @pq_ins_N(prio < half, prio, val, half, #KE{}, #KE{})
+  }(half);
+  #KB: λvals. #KB{val <> vals};
+  #KN: λlo.λhi. @pq_ins_N(prio < half, prio, val, half, lo, hi)
+}
+
+@pq_ins_N = λ{
+  0: λprio.λval.λ&half.λlo.λhi. #KN{lo, @pq_ins(prio - half, val, half / 2, hi)};
+  λc. λprio.λval.λhalf.λlo.λhi. #KN{@pq_ins(prio, val, half / 2, lo), hi}
+}
+
+@pq_pop = λheap. @pq_pop_go(0, @PQ_HALF, heap)
+
+@pq_pop_go = λ&base.λ&half. λ{
+  #KE: #PQE{};
+  #KB: λ{
+    []: #PQE{};
+    <>: λv.λt. #R{base, v, @pq_bucket(t)}
+  };
+  #KN: λlo.λhi. @pq_pop_N(base, half, @pq_pop_go(base, half / 2, lo), hi)
+}
+
+@pq_pop_N = λbase.λhalf. λ{
+  #PQE: λhi. λ{
+    #PQE: #PQE{};
+    #R: λp.λv.λrest. #R{p, v, @pq_node(#KE{}, rest)}
+  }(@pq_pop_go(base + half, half / 2, hi));
+  #R: λp.λv.λrest.λhi. #R{p, v, @pq_node(rest, hi)}
+}
+
+@pq_bucket = λ{
+  []: #KE{};
+  <>: λh.λt. #KB{h <> t}
+}
+
+@pq_node = λ{
+  #KE: λ{
+    #KE: #KE{};
+    #KN: λa.λb. #KN{#KE{}, #KN{a, b}};
+    #KB: λvals. #KN{#KE{}, #KB{vals}}
+  };
+  #KN: λa.λb.λhi. #KN{#KN{a, b}, hi};
+  #KB: λvals.λhi. #KN{#KB{vals}, hi}
+}
+"""
+
+DIJK_BTRIE = r"""
+@adj_get_lin = λ&key. λ&depth. λ{
+  #BE: #P{[], #BE{}};
+  #BL: λ&val. #P{val, #BL{val}};
+  #B: λl. λr.
+    ! bit = key % 2;
+    ! next = key / 2;
+    ! nd = depth - 1;
+    @adj_get_lin_B(bit, next, nd, l, r)
+}
+
+@adj_get_lin_B = λ{
+  0: λnext. λnd. λl. λr.
+    λ{#P: λval. λnew_l. #P{val, #B{new_l, r}}}(@adj_get_lin(next, nd, l));
+  λn. λnext. λnd. λl. λr.
+    λ{#P: λval. λnew_r. #P{val, #B{l, new_r}}}(@adj_get_lin(next, nd, r))
+}
+
+
+@dijkstra = λ{
+  #DS: λadj. λdist. λpq.
+    @dijk_pop(@pq_pop(pq), adj, dist)
+}
+
+@dijk_pop = λ{
+  #PQE: λadj. λdist. #DS{adj, dist, @pq_empty};
+  #R: λd. λu. λrest. λadj. λdist.
+    @dijk_check(adj, dist, rest, d, u)
+}
+
+@dijk_check = λadj. λdist. λpq. λ&d. λ&u.
+  λ{#P: λ&du. λdist2.
+    @dijk_stale(d > du, adj, dist2, pq, d, u)
+  }(@btrie_get_lin(u, @DEPTH, dist))
+
+@dijk_stale = λ{
+  0: λadj. λdist. λpq. λd. λu.
+    @dijk_process(adj, dist, pq, d, u);
+  λn. λadj. λdist. λpq. λd. λu.
+    @dijkstra(#DS{adj, dist, pq})
+}
+
+@dijk_process = λadj. λdist. λpq. λ&d. λu.
+  λ{#P: λneighbors. λadj2.
+    @dijk_relax_then_recurse(adj2, dist, pq, d, neighbors)
+  }(@adj_get_lin(u, @DEPTH, adj))
+
+@dijk_relax_then_recurse = λadj. λdist. λpq. λd. λneighbors.
+  λ{#DS2: λdist2. λpq2.
+    @dijkstra(#DS{adj, dist2, pq2})
+  }(@relax_all(d, neighbors, dist, pq))
+
+@relax_all = λd. λneighbors. λdist. λpq.
+  @relax_fold(neighbors, d, dist, pq)
+
+@relax_fold = λ{
+  []: λd. λdist. λpq. #DS2{dist, pq};
+  <>: λh. λt. λ&d. λdist. λpq.
+    λ{#P: λ&v. λ&w.
+      @relax_one_then_continue(t, d, v, d + w, dist, pq)
+    }(h)
+}
+
+@relax_one_then_continue = λt. λd. λ&v. λ&new_d. λdist. λpq.
+  λ{#P: λ&dv. λdist2.
+    @relax_decide(new_d < dv, t, d, v, new_d, dv, dist2, pq)
+  }(@btrie_get_lin(v, @DEPTH, dist))
+
+@relax_decide = λ{
+  0: λt. λd. λv. λnew_d. λdv. λdist. λpq.
+    @relax_fold(t, d, dist, pq);
+  λn. λt. λd. λ&v. λ&new_d. λdv. λdist. λpq.
+    ! dist2 = @btrie_set(v, new_d, @DEPTH, dist);
+    ! pq2 = @pq_insert(new_d, v, pq);
+    @relax_fold(t, d, dist2, pq2)
+}
+"""
+
+# pq kind -> (title, heap functions); bench/pq_bench.py adds the
+# lib/_pq_*_lib_.hvm4 alternatives
+DIJK_PQS = {
+    "leftist": ("leftist heap PQ", PQ_LEFTIST),
+    "bucket":  ("bucket-trie PQ", PQ_BUCKET),
+}
+
+def pq_half(max_prio):
+    """Largest power of two <= max_prio (at least 1)."""
+    h = 1
+    while h * 2 <= max_prio:
+        h *= 2
+    return h
+
+def gen_dijk_file(n, edges, dist, pq="leftist"):
+    depth = ceil_log(n, 2)
+    title, pq_funcs = DIJK_PQS[pq]
+    adj = {}
+    for u, v, w in edges:
+        adj.setdefault(u, []).append((v, w))
+    sets = []
+    for u in sorted(adj):
+        out = ", ".join(f"#P{{{v},{w}}}" for v, w in adj[u])
+        sets.append(f"  @btrie_set({u}, [{out}], @DEPTH,")
+    close = ")" * len(sets)
+    consts = f"@INF = 999999\n@DEPTH = {depth}\n"
+    extra = ""
+    if "@PQ_HALF" in pq_funcs:
+        # tentative distances never exceed the heaviest simple path
+        max_prio = (n - 1) * max((w for _, _, w in edges), default=0)
+        consts += f"@PQ_HALF = {pq_half(max_prio)}\n"
+        extra = f", pq_half={pq_half(max_prio)}"
+    adj_sets = "\n".join(sets)
+
+    return f"""// Dijkstra SSSP — linear binary trie + {title} — V={n}, E={len(edges)}, depth={depth}{extra}
+// Expected: dist[{n-1}] = {dist[n-1]}
+
+{consts}{BTRIE_FUNCS}
+{pq_funcs}
+{DIJK_BTRIE}
+// ===== adjacency trie =====
+
+@adj_trie =
+{adj_sets}
+  #BE{{}}{close}
+
+// ===== init and run =====
+
+@init_dist = @btrie_set(0, 0, @DEPTH, #BE{{}})
+@init_pq = @pq_insert(0, 0, @pq_empty)
+@init = #DS{{@adj_trie, @init_dist, @init_pq}}
+
+@result = @dijkstra(@init)
+
+@extract = λ{{#DS: λadj. λdist. λpq.
+  @btrie_get({n-1}, @DEPTH, dist)
+}}
+
+@main = @extract(@result)
+//{dist[n-1]}
+"""
+
+# ---------- compaction hooks (--gc) ----------
+
+GC_TICK_FUNCS = {
+    "@gc_tick(": r"""
+@gc_tick = λ&s. @gc_tick_go(%gc_poll(s), s)
+@gc_tick_go = λ{0: λs. s; λn. λs. %gc_done(%compact(s))}
+""",
+    "@repeat_gc(": r"""
+@repeat_gc = λ{
+  0: λ&f. λx. λn. @repeat(f, f(x), n);
+  λc. λ&f. λx. λn. @repeat(f, f(%gc_done(%compact(x))), n)
+}
+""",
+    "@repeat_go_gc(": r"""
+@repeat_go_gc = λ{
+  0: λn. λ&f. λx. @repeat_go(n, f, f(x));
+  λc. λn. λ&f. λx. @repeat_go(n, f, f(%gc_done(%compact(x))))
+}
+""",
+}
+
+# (plain loop step, step that polls the compaction policy)
+GC_REWRITES = [
+    # early-termination loops: state is already forced by @check_continue
+    ("@repeat_until_go(n - 1, f, #S{dist, 1})",
+     "@repeat_until_go(n - 1, f, @gc_tick(#S{dist, 1}))"),
+    # lazy loops: polling first makes them strict in the state
+    ("λ&f. λ&x. λ{0: x; λn. @repeat(f, f(x), n - 1)}",
+     "λf. λ&x. λ{0: x; λn. @repeat_gc(%gc_poll(x), f, x, n - 1)}"),
+    ("λn. λ&f. λx. @repeat_go(n - 1, f, f(x))",
+     "λn. λ&f. λ&x. @repeat_go_gc(%gc_poll(x), n - 1, f, x)"),
+]
+
+def with_gc(src):
+    """Rewrite the iteration combinators of a generated file to call the
+    bridge compaction policy once per round."""
+    hits = 0
+    for plain, gc in GC_REWRITES:
+        hits += src.count(plain)
+        src = src.replace(plain, gc)
+    assert hits > 0, "no loop combinator found"
+    funcs = "".join(f for use, f in GC_TICK_FUNCS.items() if use in src)
+    head, sep, tail = src.partition("\n@main = ")
+    return head + "\n" + funcs + sep + tail
+
 # ---------- main ----------
 
 # Sizes to generate.
@@ -1115,65 +1982,73 @@ SIZES = [50, 100, 200, 256, 257, 500, 1000, 1500, 2000, 5000, 10000]
 ASSOC_MAX = 100  # skip assoc-list above this size
 
 def main():
+    gc = "--gc" in sys.argv[1:]
     generated = []
+
+    def write(variant, n, src):
+        name = f"{variant}_gc_{n}.hvm4" if gc else f"{variant}_{n}.hvm4"
+        path = os.path.join(SCRIPT_DIR, name)
+        with open(path, "w") as f:
+            f.write(with_gc(src) if gc else src)
+        generated.append(path)
+
     for n in SIZES:
         edges = gen_graph(n, edges_per_node=4, seed=42 + n)
         dist = bellman_ford_py(n, edges)
         print(f"V={n:4d}  E={len(edges):5d}  "
               f"trie16_depth={ceil_log(n,16)}  trie32_depth={ceil_log(n,32)}  "
               f"btrie_depth={ceil_log(n,2)}  q4_depth={ceil_log(n,4)}  "
+              f"r8_depth={ceil_log(n,8)}  "
+              f"bkt16_depth={ceil_log(-(-n // 16), 4)}  "
               f"dist[{n-1}]={dist[n-1]}")
 
         # trie16
-        path = os.path.join(SCRIPT_DIR, f"bf_trie16_{n}.hvm4")
-        with open(path, "w") as f:
-            f.write(gen_trie16_file(n, edges, dist))
-        generated.append(path)
+        write("bf_trie16", n, gen_trie16_file(n, edges, dist))
+
+        # trie16_par (16 edge partitions, min-merged each round)
+        write("bf_trie16_par", n, gen_trie16_par_file(n, edges, dist, 16))
 
         # trie32
-        path = os.path.join(SCRIPT_DIR, f"bf_trie32_{n}.hvm4")
-        with open(path, "w") as f:
-            f.write(gen_trie32_file(n, edges, dist))
-        generated.append(path)
+        write("bf_trie32", n, gen_trie32_file(n, edges, dist))
 
         # btrie (linear binary trie)
-        path = os.path.join(SCRIPT_DIR, f"bf_btrie_{n}.hvm4")
-        with open(path, "w") as f:
-            f.write(gen_btrie_file(n, edges, dist))
-        generated.append(path)
+        write("bf_btrie", n, gen_btrie_file(n, edges, dist))
 
         # btrie_et (linear binary trie + early termination)
-        path = os.path.join(SCRIPT_DIR, f"bf_btrie_et_{n}.hvm4")
-        with open(path, "w") as f:
-            f.write(gen_btrie_et_file(n, edges, dist))
-        generated.append(path)
+        write("bf_btrie_et", n, gen_btrie_et_file(n, edges, dist))
 
         # q4_et (linear radix-4 trie + early termination)
-        path = os.path.join(SCRIPT_DIR, f"bf_q4_et_{n}.hvm4")
-        with open(path, "w") as f:
-            f.write(gen_q4_et_file(n, edges, dist))
-        generated.append(path)
+        write("bf_q4_et", n, gen_q4_et_file(n, edges, dist))
 
         # q4_adj_et (radix-4 trie + adjacency list + early termination)
-        path = os.path.join(SCRIPT_DIR, f"bf_q4_adj_et_{n}.hvm4")
-        with open(path, "w") as f:
-            f.write(gen_q4_adj_et_file(n, edges, dist))
-        generated.append(path)
+        write("bf_q4_adj_et", n, gen_q4_adj_et_file(n, edges, dist))
+
+        # r8_et (linear radix-8 trie + early termination)
+        write("bf_r8_et", n, gen_r8_et_file(n, edges, dist))
+
+        # bucketed-leaf tries: radix 4 with 8 / 16 distances per leaf
+        write("bf_bkt8_et", n, gen_bucket_et_file(n, edges, dist, 4, 8))
+        write("bf_bkt16_et", n, gen_bucket_et_file(n, edges, dist, 4, 16))
+
+        # adaptive tries: one radix-16 level over a binary trie (wide
+        # top, narrow bottom), and two binary levels over radix 16
+        write("bf_adapt_wn_et", n, gen_adaptive_et_file(n, edges, dist, 16, 1, 2))
+        write("bf_adapt_nw_et", n, gen_adaptive_et_file(n, edges, dist, 2, 2, 16))
 
         # delta-stepping btrie+ET (light/heavy edge split)
         delta = 5  # median-ish threshold for generated graphs (weights 1-20)
         ds_dist = delta_step_py(n, edges, delta)
-        path = os.path.join(SCRIPT_DIR, f"ds_btrie_et_{n}.hvm4")
-        with open(path, "w") as f:
-            f.write(gen_delta_step_et_file(n, edges, ds_dist, delta))
-        generated.append(path)
+        write("ds_btrie_et", n, gen_delta_step_et_file(n, edges, ds_dist, delta))
+
+        # Dijkstra over the binary trie: leftist heap vs bucket-trie queue
+        # (no round loop to hook compaction into, so not with --gc)
+        if not gc:
+            write("dijk_btrie", n, gen_dijk_file(n, edges, dist, "leftist"))
+            write("dijk_bq", n, gen_dijk_file(n, edges, dist, "bucket"))
 
         # assoc-list (only for small graphs)
         if n <= ASSOC_MAX:
-            path = os.path.join(SCRIPT_DIR, f"bf_assoc_{n}.hvm4")
-            with open(path, "w") as f:
-                f.write(gen_assoc_file(n, edges, dist))
-            generated.append(path)
+            write("bf_assoc", n, gen_assoc_file(n, edges, dist))
 
     print(f"\nGenerated {len(generated)} files in {SCRIPT_DIR}/")
 
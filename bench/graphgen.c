@@ -0,0 +1,380 @@
+// Graph generators for the benchmark drivers (see graphgen.h)
+
+#include "graphgen.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// M_PI is POSIX, not C11
+#define GRAPHGEN_PI 3.14159265358979323846
+
+// ---------------------------------------------------------------------------
+// Edge buffer -> CSR
+// ---------------------------------------------------------------------------
+
+typedef struct { uint32_t u, v, w; } RawEdge;
+
+typedef struct {
+  RawEdge *e;
+  uint64_t len, cap;
+} EdgeBuf;
+
+static int edges_push(EdgeBuf *b, uint32_t u, uint32_t v, uint32_t w) {
+  if (b->len == b->cap) {
+    uint64_t cap = b->cap ? b->cap * 2 : 1024;
+    RawEdge *e = realloc(b->e, cap * sizeof(RawEdge));
+    if (!e) return -1;
+    b->e   = e;
+    b->cap = cap;
+  }
+  b->e[b->len++] = (RawEdge){ u, v, w };
+  return 0;
+}
+
+// Stable counting sort by source: rows keep generation order.
+static int csr_from_edges(graphgen_csr_t *g, uint32_t n, EdgeBuf *b) {
+  memset(g, 0, sizeof(*g));
+  if (b->len > UINT32_MAX) { free(b->e); return -1; }
+  uint32_t m  = (uint32_t)b->len;
+  uint32_t *rp = calloc((size_t)n + 1, sizeof(uint32_t));
+  uint32_t *ci = malloc((m ? m : 1) * sizeof(uint32_t));
+  uint32_t *wt = malloc((m ? m : 1) * sizeof(uint32_t));
+  uint32_t *at = malloc(((size_t)n + 1) * sizeof(uint32_t));
+  if (!rp || !ci || !wt || !at) {
+    free(rp); free(ci); free(wt); free(at); free(b->e);
+    return -1;
+  }
+  for (uint32_t i = 0; i < m; i++) rp[b->e[i].u + 1]++;
+  for (uint32_t i = 1; i <= n; i++) rp[i] += rp[i - 1];
+  memcpy(at, rp, ((size_t)n + 1) * sizeof(uint32_t));
+  for (uint32_t i = 0; i < m; i++) {
+    uint32_t p = at[b->e[i].u]++;
+    ci[p] = b->e[i].v;
+    wt[p] = b->e[i].w;
+  }
+  free(at);
+  free(b->e);
+  g->n       = n;
+  g->m       = m;
+  g->row_ptr = rp;
+  g->col_idx = ci;
+  g->weight  = wt;
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Edge set for deduplication (open addressing, key = (u << 32 | v) + 1)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+  uint64_t *slot;
+  uint64_t  mask;
+} EdgeSet;
+
+static int edgeset_init(EdgeSet *s, uint64_t expect) {
+  uint64_t cap = 1024;
+  while (cap < expect * 2) cap *= 2;
+  s->slot = calloc(cap, sizeof(uint64_t));
+  s->mask = cap - 1;
+  return s->slot ? 0 : -1;
+}
+
+// Returns 1 if (u, v) was newly inserted, 0 if already present.
+static int edgeset_add(EdgeSet *s, uint32_t u, uint32_t v) {
+  uint64_t key = ((uint64_t)u << 32 | v) + 1;
+  uint64_t h   = key * 0x9E3779B97F4A7C15ull;
+  for (uint64_t i = h >> 20 & s->mask; ; i = (i + 1) & s->mask) {
+    if (s->slot[i] == key) return 0;
+    if (s->slot[i] == 0) { s->slot[i] = key; return 1; }
+  }
+}
+
+// Uniform double in [0, 1) from the 31-bit LCG.
+static double lcg_unit(graphgen_lcg_t *r) {
+  return graphgen_lcg_next(r) / 2147483648.0;
+}
+
+// ---------------------------------------------------------------------------
+// Generators
+// ---------------------------------------------------------------------------
+
+int graphgen_uniform(graphgen_csr_t *g, uint32_t n, uint32_t epn,
+                     uint32_t seed) {
+  memset(g, 0, sizeof(*g));
+  if (n == 0) return -1;
+  graphgen_lcg_t rng = { .s = seed };
+  uint64_t target = (uint64_t)n * epn;
+  EdgeBuf b = {0};
+  EdgeSet seen;
+  if (edgeset_init(&seen, target + n) != 0) return -1;
+
+  // Chain for connectivity
+  for (uint32_t i = 0; i + 1 < n; i++) {
+    uint32_t w = graphgen_lcg_next(&rng) % 10 + 1;
+    if (edges_push(&b, i, i + 1, w) != 0) goto oom;
+    edgeset_add(&seen, i, i + 1);
+  }
+
+  // Random extra edges; a rejected pair draws no weight (as in gen.py)
+  uint64_t attempts = epn > 0 ? (uint64_t)n * (epn - 1) * 2 : 0;
+  for (uint64_t a = 0; a < attempts && b.len < target; a++) {
+    uint32_t u = graphgen_lcg_next(&rng) % n;
+    uint32_t v = graphgen_lcg_next(&rng) % n;
+    if (u == v || !edgeset_add(&seen, u, v)) continue;
+    uint32_t w = graphgen_lcg_next(&rng) % 20 + 1;
+    if (edges_push(&b, u, v, w) != 0) goto oom;
+  }
+  free(seen.slot);
+  return csr_from_edges(g, n, &b);
+
+oom:
+  free(seen.slot);
+  free(b.e);
+  return -1;
+}
+
+int graphgen_forward_dag(graphgen_csr_t *g, uint32_t n, uint32_t epn,
+                         uint32_t seed) {
+  memset(g, 0, sizeof(*g));
+  if (n == 0) return -1;
+  graphgen_lcg_t rng = { .s = seed };
+  uint64_t target = (uint64_t)n * epn;
+  EdgeBuf b = {0};
+
+  // Chain for connectivity (forward: i -> i+1)
+  for (uint32_t i = 0; i + 1 < n; i++) {
+    uint32_t w = graphgen_lcg_next(&rng) % 10 + 1;
+    if (edges_push(&b, i, i + 1, w) != 0) goto oom;
+  }
+
+  // Random forward-only edges (u < v, so node order is topological)
+  uint64_t attempts = epn > 0 ? (uint64_t)n * (epn - 1) * 3 : 0;
+  for (uint64_t a = 0; a < attempts && b.len < target; a++) {
+    uint32_t u = graphgen_lcg_next(&rng) % n;
+    uint32_t v = graphgen_lcg_next(&rng) % n;
+    if (u >= v) continue;
+    uint32_t w = graphgen_lcg_next(&rng) % 20 + 1;
+    if (edges_push(&b, u, v, w) != 0) goto oom;
+  }
+  return csr_from_edges(g, n, &b);
+
+oom:
+  free(b.e);
+  return -1;
+}
+
+int graphgen_layered_dag(graphgen_csr_t *g, uint32_t layers, uint32_t width,
+                         uint32_t epn, uint32_t seed) {
+  memset(g, 0, sizeof(*g));
+  uint64_t n = (uint64_t)layers * width;
+  if (n == 0 || n > UINT32_MAX) return -1;
+  graphgen_lcg_t rng = { .s = seed };
+  EdgeBuf b = {0};
+
+  for (uint32_t l = 0; l + 1 < layers; l++) {
+    uint32_t base = l * width, next = base + width;
+    for (uint32_t i = 0; i < width; i++) {
+      // Straight edge keeps every node reachable from its column
+      uint32_t w = graphgen_lcg_next(&rng) % 10 + 1;
+      if (edges_push(&b, base + i, next + i, w) != 0) goto oom;
+      for (uint32_t k = 1; k < epn; k++) {
+        uint32_t v = next + graphgen_lcg_next(&rng) % width;
+        w = graphgen_lcg_next(&rng) % 20 + 1;
+        if (edges_push(&b, base + i, v, w) != 0) goto oom;
+      }
+    }
+  }
+  return csr_from_edges(g, (uint32_t)n, &b);
+
+oom:
+  free(b.e);
+  return -1;
+}
+
+int graphgen_grid(graphgen_csr_t *g, uint32_t rows, uint32_t cols,
+                  uint32_t seed) {
+  memset(g, 0, sizeof(*g));
+  uint64_t n = (uint64_t)rows * cols;
+  if (n == 0 || n > UINT32_MAX) return -1;
+  graphgen_lcg_t rng = { .s = seed };
+  EdgeBuf b = {0};
+
+  for (uint32_t r = 0; r < rows; r++) {
+    for (uint32_t c = 0; c < cols; c++) {
+      uint32_t u = r * cols + c;
+      if (c + 1 < cols) {
+        if (edges_push(&b, u, u + 1, graphgen_lcg_next(&rng) % 20 + 1) != 0 ||
+            edges_push(&b, u + 1, u, graphgen_lcg_next(&rng) % 20 + 1) != 0)
+          goto oom;
+      }
+      if (r + 1 < rows) {
+        if (edges_push(&b, u, u + cols, graphgen_lcg_next(&rng) % 20 + 1) != 0 ||
+            edges_push(&b, u + cols, u, graphgen_lcg_next(&rng) % 20 + 1) != 0)
+          goto oom;
+      }
+    }
+  }
+  return csr_from_edges(g, (uint32_t)n, &b);
+
+oom:
+  free(b.e);
+  return -1;
+}
+
+int graphgen_rmat(graphgen_csr_t *g, uint32_t scale, uint32_t epn,
+                  double a, double b, double c, uint32_t seed) {
+  memset(g, 0, sizeof(*g));
+  if (scale == 0 || scale > 31 || a + b + c > 1.0) return -1;
+  uint32_t n = 1u << scale;
+  uint64_t m = (uint64_t)n * epn;
+  graphgen_lcg_t rng = { .s = seed };
+  EdgeBuf buf = {0};
+
+  for (uint64_t e = 0; e < m; e++) {
+    uint32_t u = 0, v = 0;
+    for (uint32_t bit = n >> 1; bit; bit >>= 1) {
+      double r = lcg_unit(&rng);
+      if (r < a)              { }
+      else if (r < a + b)     { v |= bit; }
+      else if (r < a + b + c) { u |= bit; }
+      else                    { u |= bit; v |= bit; }
+    }
+    uint32_t w = graphgen_lcg_next(&rng) % 20 + 1;
+    if (u == v) continue;
+    if (edges_push(&buf, u, v, w) != 0) goto oom;
+  }
+  return csr_from_edges(g, n, &buf);
+
+oom:
+  free(buf.e);
+  return -1;
+}
+
+int graphgen_geometric(graphgen_csr_t *g, uint32_t n, uint32_t epn,
+                       uint32_t seed) {
+  memset(g, 0, sizeof(*g));
+  if (n == 0 || epn == 0) return -1;
+  graphgen_lcg_t rng = { .s = seed };
+  double radius = sqrt((double)epn / (GRAPHGEN_PI * n));
+  uint32_t k = radius < 1.0 ? (uint32_t)(1.0 / radius) : 1;
+  if (k > 65535) k = 65535;
+  uint64_t cells = (uint64_t)k * k;
+
+  double   *x    = malloc((size_t)n * sizeof(double));
+  double   *y    = malloc((size_t)n * sizeof(double));
+  uint32_t *cell = malloc((size_t)n * sizeof(uint32_t));
+  uint32_t *head = calloc(cells + 1, sizeof(uint32_t));
+  uint32_t *pts  = malloc((size_t)n * sizeof(uint32_t));
+  EdgeBuf b = {0};
+  int rc = -1;
+  if (!x || !y || !cell || !head || !pts) goto done;
+
+  // Points, bucketed into k x k cells of side >= radius
+  for (uint32_t i = 0; i < n; i++) {
+    x[i] = lcg_unit(&rng);
+    y[i] = lcg_unit(&rng);
+    uint32_t cx = (uint32_t)(x[i] * k), cy = (uint32_t)(y[i] * k);
+    cell[i] = cy * k + cx;
+    head[cell[i] + 1]++;
+  }
+  for (uint64_t c = 1; c <= cells; c++) head[c] += head[c - 1];
+  {
+    uint32_t *at = malloc(cells * sizeof(uint32_t));
+    if (!at) goto done;
+    memcpy(at, head, cells * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) pts[at[cell[i]]++] = i;
+    free(at);
+  }
+
+  // Each node links to every point within radius in the 3x3 neighbourhood
+  for (uint32_t u = 0; u < n; u++) {
+    int64_t cx = cell[u] % k, cy = cell[u] / k;
+    for (int64_t dy = -1; dy <= 1; dy++) {
+      for (int64_t dx = -1; dx <= 1; dx++) {
+        int64_t nx = cx + dx, ny = cy + dy;
+        if (nx < 0 || ny < 0 || nx >= k || ny >= k) continue;
+        uint64_t c = (uint64_t)ny * k + (uint64_t)nx;
+        for (uint32_t p = head[c]; p < head[c + 1]; p++) {
+          uint32_t v = pts[p];
+          if (v == u) continue;
+          double ddx = x[u] - x[v], ddy = y[u] - y[v];
+          double d = sqrt(ddx * ddx + ddy * ddy);
+          if (d >= radius) continue;
+          uint32_t w = 1 + (uint32_t)(d / radius * 19.0);
+          if (edges_push(&b, u, v, w) != 0) goto done;
+        }
+      }
+    }
+  }
+  rc = csr_from_edges(g, n, &b);
+  b.e = NULL;
+
+done:
+  free(b.e);
+  free(x);
+  free(y);
+  free(cell);
+  free(head);
+  free(pts);
+  return rc;
+}
+
+void graphgen_free(graphgen_csr_t *g) {
+  free(g->row_ptr);
+  free(g->col_idx);
+  free(g->weight);
+  memset(g, 0, sizeof(*g));
+}
+
+// ---------------------------------------------------------------------------
+// Binary CSR I/O
+// ---------------------------------------------------------------------------
+
+int graphgen_write(const graphgen_csr_t *g, const char *path) {
+  FILE *f = fopen(path, "wb");
+  if (!f) return -1;
+  uint32_t hdr[2] = { g->n, g->m };
+  int ok = fwrite("CSR1", 1, 4, f) == 4
+        && fwrite(hdr, sizeof(uint32_t), 2, f) == 2
+        && fwrite(g->row_ptr, sizeof(uint32_t), (size_t)g->n + 1, f)
+             == (size_t)g->n + 1
+        && fwrite(g->col_idx, sizeof(uint32_t), g->m, f) == g->m
+        && fwrite(g->weight, sizeof(uint32_t), g->m, f) == g->m;
+  if (fclose(f) != 0) ok = 0;
+  return ok ? 0 : -1;
+}
+
+int graphgen_read(graphgen_csr_t *g, const char *path) {
+  memset(g, 0, sizeof(*g));
+  FILE *f = fopen(path, "rb");
+  if (!f) return -1;
+  char magic[4];
+  uint32_t hdr[2];
+  if (fread(magic, 1, 4, f) != 4 || memcmp(magic, "CSR1", 4) != 0 ||
+      fread(hdr, sizeof(uint32_t), 2, f) != 2) {
+    fclose(f);
+    return -1;
+  }
+  uint32_t n = hdr[0], m = hdr[1];
+  uint32_t *rp = malloc(((size_t)n + 1) * sizeof(uint32_t));
+  uint32_t *ci = malloc((m ? m : 1) * sizeof(uint32_t));
+  uint32_t *wt = malloc((m ? m : 1) * sizeof(uint32_t));
+  int ok = rp && ci && wt
+        && fread(rp, sizeof(uint32_t), (size_t)n + 1, f) == (size_t)n + 1
+        && fread(ci, sizeof(uint32_t), m, f) == m
+        && fread(wt, sizeof(uint32_t), m, f) == m
+        && rp[n] == m;
+  fclose(f);
+  if (!ok) {
+    free(rp); free(ci); free(wt);
+    return -1;
+  }
+  g->n       = n;
+  g->m       = m;
+  g->row_ptr = rp;
+  g->col_idx = ci;
+  g->weight  = wt;
+  return 0;
+}
@@ -0,0 +1,84 @@
+// Graph generators for the benchmark drivers
+// ===========================================
+//
+// One implementation of every synthetic graph the benchmarks use, shared by
+// bench/hybrid_bf.c, bench/dag_dp.c, lib/benchmark.c and the graphgen CLI.
+// All generators are deterministic in their seed and produce CSR directly:
+//
+//   graphgen_uniform      - chain 0->1->..->n-1 plus random edges, deduped;
+//                           bit-compatible with gen_graph() in bench/gen.py
+//   graphgen_forward_dag  - chain plus random u<v edges (dag_dp's DAG)
+//   graphgen_layered_dag  - `layers` x `width` nodes, edges only between
+//                           consecutive layers
+//   graphgen_grid         - rows x cols 4-neighbour grid, both directions
+//   graphgen_rmat         - R-MAT power-law graph on 2^scale nodes
+//   graphgen_geometric    - random geometric graph in the unit square,
+//                           both directions, weight ~ Euclidean length
+//
+// The uniform model inherits gen.py's use of the LCG's low bits (s % n),
+// which repeat with a short period when n is a power of two: large
+// power-of-two n yields far fewer than n * epn distinct edges. Use rmat or
+// geometric for large-scale runs.
+//
+// Weights are in [1, 20] everywhere (chain edges [1, 10], as in gen.py).
+// Edges keep their generation order within a source row, so the CSR rows
+// list edges in the same order gen.py writes them.
+//
+// Binary CSR files (graphgen_write / graphgen_read), native endianness:
+//
+//   char     magic[4] = "CSR1"
+//   uint32_t n, m
+//   uint32_t row_ptr[n + 1], col_idx[m], weight[m]
+//
+// Compile with the driver: clang -O2 -o bench/X bench/X.c bench/graphgen.c
+
+#ifndef GRAPHGEN_H
+#define GRAPHGEN_H
+
+#include <stdint.h>
+
+typedef struct {
+  uint32_t  n;         // nodes
+  uint32_t  m;         // edges
+  uint32_t *row_ptr;   // n + 1 offsets into col_idx/weight
+  uint32_t *col_idx;   // m targets
+  uint32_t *weight;    // m weights
+} graphgen_csr_t;
+
+// LCG used by bench/gen.py: s = (s * 1103515245 + 12345) & 0x7fffffff
+typedef struct { uint32_t s; } graphgen_lcg_t;
+
+static inline uint32_t graphgen_lcg_next(graphgen_lcg_t *r) {
+  r->s = (r->s * 1103515245u + 12345u) & 0x7fffffffu;
+  return r->s;
+}
+
+// Every generator returns 0 on success, -1 on bad arguments or OOM
+// (in which case *g is left empty).
+int graphgen_uniform(graphgen_csr_t *g, uint32_t n, uint32_t epn,
+                     uint32_t seed);
+int graphgen_forward_dag(graphgen_csr_t *g, uint32_t n, uint32_t epn,
+                         uint32_t seed);
+int graphgen_layered_dag(graphgen_csr_t *g, uint32_t layers, uint32_t width,
+                         uint32_t epn, uint32_t seed);
+int graphgen_grid(graphgen_csr_t *g, uint32_t rows, uint32_t cols,
+                  uint32_t seed);
+
+// a, b, c: quadrant probabilities (d = 1 - a - b - c); the usual choice is
+// 0.57, 0.19, 0.19. Self-loops are dropped, so m can fall short of
+// epn * 2^scale by a little.
+int graphgen_rmat(graphgen_csr_t *g, uint32_t scale, uint32_t epn,
+                  double a, double b, double c, uint32_t seed);
+
+// Connects points closer than sqrt(epn / (pi * n)), i.e. ~epn neighbours
+// per node on average.
+int graphgen_geometric(graphgen_csr_t *g, uint32_t n, uint32_t epn,
+                       uint32_t seed);
+
+void graphgen_free(graphgen_csr_t *g);
+
+// Binary CSR I/O. Return 0 on success, -1 on I/O error or bad file.
+int graphgen_write(const graphgen_csr_t *g, const char *path);
+int graphgen_read(graphgen_csr_t *g, const char *path);
+
+#endif
@@ -0,0 +1,453 @@
+// In-process benchmark harness for .hvm4 files
+// Loads every file through the C bridge and runs warmup + N timed
+// evaluations in one process, so results are free of the ~2 ms fork/exec
+// baseline of running ./HVM4/clang/main per iteration and need no scraping
+// of ANSI-decorated output.
+//
+// Each iteration resets the runtime, parses the file and evaluates @main;
+// only the evaluation is timed (parse time is reported separately, best of
+// all iterations). RSS delta is resident memory after evaluation minus
+// resident memory after the reset, the largest seen over the iterations.
+//
+// Compile: clang -O2 -o bench/hvm4_bench bench/hvm4_bench.c -lpthread
+// Usage:   ./bench/hvm4_bench [--runs=N] [--warmup=N] [-C N]
+//                             [--format=table|csv|json] [--no-header] [FILE ...]
+//
+// Without FILE arguments it runs src/path_*.hvm4 and bench/*.hvm4.
+//
+// --runs=N          timed iterations per file (default 5)
+// --warmup=N        untimed iterations before those (default 1)
+// -C N              collapse mode with N results for the files that follow
+//                   (e.g. sup_enum needs -C10); -C 0 switches back
+// --format=...      table (default), csv or json
+// --no-header       omit the csv header / table header (for concatenation)
+//
+// Regression baselines (interaction counts are deterministic for a given
+// program and thread count, so they make a far steadier signal than time):
+//
+// --write-baseline=FILE  record itrs, result count, result hash and heap
+//                        words per file (and -C mode) in FILE
+// --check=FILE           compare against FILE instead of printing timings;
+//                        exits 1 if any file's interactions or heap words
+//                        grew by more than --tolerance, its result changed,
+//                        or a file listed in FILE was not run
+// --tolerance=PCT        allowed growth in percent (default 1)
+//
+// Baseline file: one line per program, tab-separated, '#' comments:
+//
+//   file  collapse  itrs  results  hash  heap_words
+//
+// hash is FNV-1a over the extracted values (8 hex digits); "-" in hash or
+// heap_words skips that comparison.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glob.h>
+#include <sys/resource.h>
+#include <pthread.h>
+
+#include "../c3lib/csrc/hvm4_bridge.c"
+
+// Initial result buffer; normalize mode grows it to the full result count.
+#define MAX_OUT 4096
+
+enum { FMT_TABLE, FMT_CSV, FMT_JSON };
+
+typedef struct {
+  const char *path;
+  int         ok;
+  int         runs;
+  double      min_us, median_us, p95_us, mean_us;
+  double      parse_us;
+  u64         itrs;
+  double      mips;
+  long        rss_delta_kb;
+  int         count;
+  uint32_t    first;       // first extracted value, for eyeballing
+  uint32_t    hash;        // FNV-1a of all extracted values
+  uint64_t    heap_words;  // heap in use after evaluation
+  int         collapse;
+} BenchResult;
+
+typedef struct {
+  char     path[256];
+  int      collapse;
+  uint64_t itrs;
+  int      count;
+  uint32_t hash;
+  uint64_t heap_words;
+  int      has_hash, has_heap;
+} BaselineEntry;
+
+static double now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+static long rss_kb(void) {
+  FILE *f = fopen("/proc/self/statm", "r");
+  long size = 0, resident = 0;
+  if (f) {
+    if (fscanf(f, "%ld %ld", &size, &resident) != 2) resident = 0;
+    fclose(f);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static char *read_file(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *buf = malloc((size_t)len + 1);
+  if (buf && fread(buf, 1, (size_t)len, f) != (size_t)len) {
+    free(buf);
+    buf = NULL;
+  }
+  if (buf) buf[len] = '\0';
+  fclose(f);
+  return buf;
+}
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static uint32_t fnv1a(const uint32_t *v, int n) {
+  uint32_t h = 2166136261u;
+  for (int i = 0; i < n; i++) {
+    for (int b = 0; b < 4; b++) {
+      h ^= (v[i] >> (8 * b)) & 0xff;
+      h *= 16777619u;
+    }
+  }
+  return h;
+}
+
+// Nearest-rank percentile of a sorted sample.
+static double percentile(const double *v, int n, double p) {
+  int k = (int)(p / 100.0 * n + 0.999999) - 1;
+  if (k < 0) k = 0;
+  if (k >= n) k = n - 1;
+  return v[k];
+}
+
+static BenchResult bench_file(const char *path, int warmup, int runs,
+                              int collapse) {
+  BenchResult r = { .path = path, .runs = runs, .collapse = collapse };
+  char *src = read_file(path);
+  if (!src) return r;
+
+  double   *times = malloc((size_t)runs * sizeof(double));
+  int       cap   = collapse > MAX_OUT ? collapse : MAX_OUT;
+  uint32_t *out   = malloc((size_t)cap * sizeof(uint32_t));
+  r.parse_us = -1;
+
+  for (int it = 0; it < warmup + runs; it++) {
+    hvm4_lib_reset();
+    long rss0 = rss_kb();
+
+    double t0 = now_us();
+    if (hvm4_parse(src) != 0) break;
+    double t1 = now_us();
+    int count = hvm4_eval(collapse, out, cap);
+    double t2 = now_us();
+    if (count < 0) break;
+    if (count > cap) {
+      // Normalize mode reports the full count: extract all of it
+      uint32_t *grown = realloc(out, (size_t)count * sizeof(uint32_t));
+      if (!grown) break;
+      out = grown;
+      cap = count;
+      hvm4_extract(out, cap);
+    }
+
+    hvm4_stats_t st;
+    hvm4_stats(&st);
+    long drss = rss_kb() - rss0;
+    if (r.parse_us < 0 || t1 - t0 < r.parse_us) r.parse_us = t1 - t0;
+    if (drss > r.rss_delta_kb) r.rss_delta_kb = drss;
+    r.itrs  = st.itrs;
+    r.count = count;
+    r.first = count > 0 ? out[0] : 0;
+    r.hash  = fnv1a(out, count);
+    r.heap_words = st.heap_words;
+    if (it >= warmup) times[it - warmup] = t2 - t1;
+    if (it == warmup + runs - 1) r.ok = 1;
+  }
+
+  if (r.ok) {
+    double sum = 0;
+    for (int i = 0; i < runs; i++) sum += times[i];
+    qsort(times, (size_t)runs, sizeof(double), cmp_double);
+    r.min_us    = times[0];
+    r.median_us = runs % 2 ? times[runs / 2]
+                           : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+    r.p95_us    = percentile(times, runs, 95);
+    r.mean_us   = sum / runs;
+    r.mips      = r.min_us > 0 ? r.itrs / r.min_us : 0;
+  }
+  free(times);
+  free(out);
+  free(src);
+  return r;
+}
+
+static void print_header(int fmt) {
+  if (fmt == FMT_CSV) {
+    printf("file,runs,min_us,median_us,p95_us,mean_us,parse_us,itrs,mips,"
+           "rss_delta_kb,results,first\n");
+  } else if (fmt == FMT_TABLE) {
+    printf("%-34s %12s %10s %10s %10s %10s %10s %9s\n", "File", "Itrs",
+           "Min (us)", "Med (us)", "p95 (us)", "Parse (us)", "MIPS",
+           "dRSS (KB)");
+    for (int i = 0; i < 112; i++) putchar('-');
+    putchar('\n');
+  }
+}
+
+static void print_result(int fmt, const BenchResult *r, int first) {
+  if (fmt == FMT_CSV) {
+    if (!r->ok) {
+      printf("%s,%d,,,,,,,,,,\n", r->path, r->runs);
+      return;
+    }
+    printf("%s,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%llu,%.2f,%ld,%d,%u\n", r->path,
+           r->runs, r->min_us, r->median_us, r->p95_us, r->mean_us,
+           r->parse_us, (unsigned long long)r->itrs, r->mips,
+           r->rss_delta_kb, r->count, r->first);
+  } else if (fmt == FMT_JSON) {
+    printf("%s  {\"file\": \"%s\", \"ok\": %s", first ? "" : ",\n", r->path,
+           r->ok ? "true" : "false");
+    if (r->ok) {
+      printf(", \"runs\": %d, \"min_us\": %.1f, \"median_us\": %.1f, "
+             "\"p95_us\": %.1f, \"mean_us\": %.1f, \"parse_us\": %.1f, "
+             "\"itrs\": %llu, \"mips\": %.2f, \"rss_delta_kb\": %ld, "
+             "\"results\": %d, \"first\": %u",
+             r->runs, r->min_us, r->median_us, r->p95_us, r->mean_us,
+             r->parse_us, (unsigned long long)r->itrs, r->mips,
+             r->rss_delta_kb, r->count, r->first);
+    }
+    printf("}");
+  } else {
+    if (!r->ok) {
+      printf("%-34s %12s\n", r->path, "FAIL");
+      return;
+    }
+    printf("%-34s %12llu %10.1f %10.1f %10.1f %10.1f %10.2f %9ld\n", r->path,
+           (unsigned long long)r->itrs, r->min_us, r->median_us, r->p95_us,
+           r->parse_us, r->mips, r->rss_delta_kb);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Baselines
+// ---------------------------------------------------------------------------
+
+static int write_baseline(const char *path, const BenchResult *rs, int n) {
+  FILE *f = fopen(path, "w");
+  if (!f) return -1;
+  fprintf(f, "# hvm4_bench baseline (./bench.sh --baseline)\n"
+             "# file\tcollapse\titrs\tresults\thash\theap_words\n");
+  for (int i = 0; i < n; i++) {
+    if (!rs[i].ok) continue;
+    fprintf(f, "%s\t%d\t%llu\t%d\t%08x\t%llu\n", rs[i].path, rs[i].collapse,
+            (unsigned long long)rs[i].itrs, rs[i].count, rs[i].hash,
+            (unsigned long long)rs[i].heap_words);
+  }
+  return fclose(f) == 0 ? 0 : -1;
+}
+
+// Returns the number of entries read into *out (malloc'd), or -1.
+static int read_baseline(const char *path, BaselineEntry **out) {
+  *out = NULL;
+  FILE *f = fopen(path, "r");
+  if (!f) return -1;
+  int n = 0, cap = 64;
+  BaselineEntry *es = malloc((size_t)cap * sizeof(BaselineEntry));
+  char line[512], hash[32], heap[32];
+  while (es && fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || line[0] == '\n') continue;
+    if (n == cap) {
+      cap *= 2;
+      BaselineEntry *grown = realloc(es, (size_t)cap * sizeof(BaselineEntry));
+      if (!grown) break;
+      es = grown;
+    }
+    BaselineEntry *e = &es[n];
+    unsigned long long itrs;
+    if (sscanf(line, "%255s %d %llu %d %31s %31s", e->path, &e->collapse,
+               &itrs, &e->count, hash, heap) != 6) {
+      continue;
+    }
+    e->itrs       = itrs;
+    e->has_hash   = strcmp(hash, "-") != 0;
+    e->hash       = e->has_hash ? (uint32_t)strtoul(hash, NULL, 16) : 0;
+    e->has_heap   = strcmp(heap, "-") != 0;
+    e->heap_words = e->has_heap ? strtoull(heap, NULL, 10) : 0;
+    n++;
+  }
+  fclose(f);
+  *out = es;
+  return es ? n : -1;
+}
+
+static double growth_pct(uint64_t base, uint64_t now) {
+  if (base == 0) return now ? 100.0 : 0.0;
+  return ((double)now - (double)base) * 100.0 / (double)base;
+}
+
+// Prints one row per result; returns the number of regressions.
+static int check_baseline(const BaselineEntry *es, int ne,
+                          const BenchResult *rs, int n, double tol) {
+  int bad = 0;
+  printf("%-44s %12s %12s %8s %8s %-9s\n", "File", "Base itrs", "Itrs",
+         "dItrs", "dHeap", "Status");
+  for (int i = 0; i < 98; i++) putchar('-');
+  putchar('\n');
+  for (int i = 0; i < n; i++) {
+    const BenchResult *r = &rs[i];
+    const BaselineEntry *e = NULL;
+    for (int j = 0; j < ne && !e; j++) {
+      if (es[j].collapse == r->collapse && strcmp(es[j].path, r->path) == 0) {
+        e = &es[j];
+      }
+    }
+    if (!r->ok) {
+      printf("%-44s %12s %12s %8s %8s %-9s\n", r->path, "", "", "", "", "FAIL");
+      bad++;
+      continue;
+    }
+    if (!e) {
+      printf("%-44s %12s %12llu %8s %8s %-9s\n", r->path, "-",
+             (unsigned long long)r->itrs, "", "", "NEW");
+      continue;
+    }
+    double di = growth_pct(e->itrs, r->itrs);
+    double dh = e->has_heap ? growth_pct(e->heap_words, r->heap_words) : 0.0;
+    const char *status = "ok";
+    if (r->count != e->count || (e->has_hash && r->hash != e->hash)) {
+      status = "RESULT";
+      bad++;
+    } else if (di > tol || dh > tol) {
+      status = "REGRESSED";
+      bad++;
+    } else if (di < -tol) {
+      status = "improved";
+    }
+    printf("%-44s %12llu %12llu %+7.1f%% ", r->path,
+           (unsigned long long)e->itrs, (unsigned long long)r->itrs, di);
+    if (e->has_heap) {
+      printf("%+7.1f%% ", dh);
+    } else {
+      printf("%8s ", "-");
+    }
+    printf("%-9s\n", status);
+  }
+  // A baseline program that did not run is a failure, not a pass
+  for (int j = 0; j < ne; j++) {
+    int ran = 0;
+    for (int i = 0; i < n && !ran; i++) {
+      ran = es[j].collapse == rs[i].collapse
+         && strcmp(es[j].path, rs[i].path) == 0;
+    }
+    if (ran) continue;
+    printf("%-44s %12llu %12s %8s %8s %-9s\n", es[j].path,
+           (unsigned long long)es[j].itrs, "-", "", "", "MISSING");
+    bad++;
+  }
+  printf("\n%d regression(s) at %.1f%% tolerance\n", bad, tol);
+  return bad;
+}
+
+int main(int argc, char **argv) {
+  int runs = 5, warmup = 1, collapse = 0, fmt = FMT_TABLE, header = 1;
+  const char *base_out = NULL, *base_in = NULL;
+  double      tolerance = 1.0;
+  const char **files = malloc((size_t)argc * sizeof(char *));
+  int         *modes = malloc((size_t)argc * sizeof(int));
+  int nfiles = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--runs=", 7) == 0) {
+      runs = atoi(argv[i] + 7);
+    } else if (strncmp(argv[i], "--warmup=", 9) == 0) {
+      warmup = atoi(argv[i] + 9);
+    } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+      collapse = atoi(argv[++i]);
+    } else if (strncmp(argv[i], "-C", 2) == 0 && argv[i][2]) {
+      collapse = atoi(argv[i] + 2);
+    } else if (strncmp(argv[i], "--format=", 9) == 0) {
+      const char *f = argv[i] + 9;
+      fmt = strcmp(f, "csv") == 0 ? FMT_CSV
+          : strcmp(f, "json") == 0 ? FMT_JSON : FMT_TABLE;
+    } else if (strcmp(argv[i], "--no-header") == 0) {
+      header = 0;
+    } else if (strncmp(argv[i], "--write-baseline=", 17) == 0) {
+      base_out = argv[i] + 17;
+    } else if (strncmp(argv[i], "--check=", 8) == 0) {
+      base_in = argv[i] + 8;
+    } else if (strncmp(argv[i], "--tolerance=", 12) == 0) {
+      tolerance = atof(argv[i] + 12);
+    } else {
+      modes[nfiles]   = collapse;
+      files[nfiles++] = argv[i];
+    }
+  }
+  if (runs < 1) runs = 1;
+  if (warmup < 0) warmup = 0;
+
+  glob_t g = {0};
+  if (nfiles == 0) {
+    glob("src/path_*.hvm4", 0, NULL, &g);
+    glob("bench/*.hvm4", GLOB_APPEND, NULL, &g);
+    files = realloc(files, (g.gl_pathc + 1) * sizeof(char *));
+    modes = realloc(modes, (g.gl_pathc + 1) * sizeof(int));
+    for (size_t i = 0; i < g.gl_pathc; i++) {
+      modes[nfiles]   = collapse;
+      files[nfiles++] = g.gl_pathv[i];
+    }
+  }
+
+  BaselineEntry *base = NULL;
+  int nbase = 0;
+  if (base_in && (nbase = read_baseline(base_in, &base)) < 0) {
+    fprintf(stderr, "cannot read baseline %s (record one with "
+                    "--write-baseline=FILE)\n", base_in);
+    return 1;
+  }
+
+  BenchResult *results = malloc((size_t)(nfiles ? nfiles : 1) * sizeof(BenchResult));
+  hvm4_lib_init();
+  if (!base_in && header) print_header(fmt);
+  if (!base_in && fmt == FMT_JSON) printf("[\n");
+  int failed = 0;
+  for (int i = 0; i < nfiles; i++) {
+    BenchResult r = bench_file(files[i], warmup, runs, modes[i]);
+    results[i] = r;
+    failed += !r.ok;
+    if (base_in) continue;
+    print_result(fmt, &r, i == 0);
+    fflush(stdout);
+  }
+  if (!base_in && fmt == FMT_JSON) printf("\n]\n");
+  hvm4_lib_cleanup();
+
+  if (base_out && write_baseline(base_out, results, nfiles) != 0) {
+    fprintf(stderr, "cannot write baseline %s\n", base_out);
+    failed++;
+  }
+  if (base_in) failed = check_baseline(base, nbase, results, nfiles, tolerance);
+  free(base);
+  free(results);
+
+  globfree(&g);
+  free(files);
+  free(modes);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+// In-process .hvm4 runner
+// Loads a program through the C bridge, evaluates @main and prints the
+// extracted numbers with the interaction count and timing. Unlike
+// HVM4/clang/main, it runs the program exactly as the C3/lib drivers do
+// (same primitives, same reset path), so it can also host the profiler.
+//
+// Compile: clang -O2 -o bench/hvm4_run bench/hvm4_run.c -lpthread
+//          clang -O2 -DHVM4_PROFILE -o bench/hvm4_run_prof bench/hvm4_run.c -lpthread
+// Usage:   ./bench/hvm4_run [-C N] [--root=NAME] [--census]
+//                           [--profile[=table|folded]] [--out=FILE]
+//                           [--folded=FILE] FILE.hvm4
+//
+// -C N                     collapse mode, at most N results (like main -C N)
+// --root=NAME              evaluate @NAME instead of @main
+// --census                 print the heap census of the result: live words
+//                          per node kind and the live/garbage split
+// --profile=table|folded   print the per-definition profile after the run
+//                          (requires an -DHVM4_PROFILE build); `folded`
+//                          writes collapsed stacks for flamegraph tools
+// --out=FILE               write the profile to FILE instead of stdout
+// --folded=FILE            also write collapsed stacks to FILE, so one run
+//                          gives both the table and the flame graph input
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <pthread.h>
+
+#include "../c3lib/csrc/hvm4_bridge.c"
+
+#define MAX_OUT (1 << 20)
+
+static long peak_rss_kb(void) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+static char *read_file(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *buf = malloc((size_t)len + 1);
+  if (buf && fread(buf, 1, (size_t)len, f) != (size_t)len) {
+    free(buf);
+    buf = NULL;
+  }
+  if (buf) buf[len] = '\0';
+  fclose(f);
+  return buf;
+}
+
+int main(int argc, char **argv) {
+  const char *path     = NULL;
+  const char *profile  = NULL;
+  const char *out_path = NULL;
+  const char *folded   = NULL;
+  const char *root     = "main";
+  int         census   = 0;
+  int         collapse = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+      collapse = atoi(argv[++i]);
+    } else if (strncmp(argv[i], "-C", 2) == 0 && argv[i][2]) {
+      collapse = atoi(argv[i] + 2);
+    } else if (strncmp(argv[i], "--root=", 7) == 0) {
+      root = argv[i] + 7;
+    } else if (strcmp(argv[i], "--census") == 0) {
+      census = 1;
+    } else if (strcmp(argv[i], "--profile") == 0) {
+      profile = "table";
+    } else if (strncmp(argv[i], "--profile=", 10) == 0) {
+      profile = argv[i] + 10;
+    } else if (strncmp(argv[i], "--out=", 6) == 0) {
+      out_path = argv[i] + 6;
+    } else if (strncmp(argv[i], "--folded=", 9) == 0) {
+      folded = argv[i] + 9;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-C N] [--root=NAME] [--census] "
+                    "[--profile[=table|folded]] [--out=FILE] "
+                    "[--folded=FILE] FILE.hvm4\n",
+            argv[0]);
+    return 1;
+  }
+#ifndef HVM4_PROFILE
+  if (profile || out_path || folded) {
+    fprintf(stderr, "%s: built without -DHVM4_PROFILE\n", argv[0]);
+    return 1;
+  }
+#else
+  if (profile && strcmp(profile, "table") != 0 &&
+      strcmp(profile, "folded") != 0) {
+    fprintf(stderr, "unknown profile format: %s\n", profile);
+    return 1;
+  }
+#endif
+
+  char *src = read_file(path);
+  if (!src) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 1;
+  }
+
+  hvm4_lib_init();
+  hvm4_lib_reset();
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  int rc = hvm4_parse(src);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double parse_s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+  free(src);
+  if (rc != 0) {
+    fprintf(stderr, "%s: parse failed or @main missing\n", path);
+    hvm4_lib_cleanup();
+    return 1;
+  }
+  if (strcmp(root, "main") != 0 &&
+      BOOK[table_find(root, (u32)strlen(root))] == 0) {
+    fprintf(stderr, "%s: @%s is not defined\n", path, root);
+    hvm4_lib_cleanup();
+    return 1;
+  }
+
+  uint32_t *out = malloc(MAX_OUT * sizeof(uint32_t));
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  int count = hvm4_eval_def(root, collapse, out, MAX_OUT);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double eval_s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+  if (count < 0) {
+    fprintf(stderr, "%s: hvm4_eval returned %d\n", path, count);
+    free(out);
+    hvm4_lib_cleanup();
+    return 1;
+  }
+
+  int shown = count < MAX_OUT ? count : MAX_OUT;
+  for (int i = 0; i < shown && i < 64; i++) {
+    printf("%s%u", i ? " " : "", out[i]);
+  }
+  printf("%s\n", shown > 64 ? " ..." : "");
+
+  hvm4_stats_t st;
+  hvm4_stats(&st);
+  printf("- Results: %d\n", count);
+  printf("- Itrs: %llu\n", (unsigned long long)st.itrs);
+  printf("- Parse: %.6f s\n", parse_s);
+  printf("- Time: %.6f s\n", eval_s);
+  printf("- Perf: %.2f MIPS\n", eval_s > 0 ? st.itrs / eval_s / 1e6 : 0.0);
+  printf("- RSS: %ld KB\n", peak_rss_kb());
+
+  hvm4_census_t cs;
+  if (census && hvm4_census(&cs) != 0) {
+    fprintf(stderr, "%s: census failed (collapse mode, or out of memory)\n",
+            path);
+  } else if (census) {
+    printf("- Census: live=%llu heap=%llu garbage=%.1f%%\n",
+           (unsigned long long)cs.live_words,
+           (unsigned long long)cs.heap_words,
+           cs.heap_words ? 100.0 * cs.garbage_words / cs.heap_words : 0.0);
+    printf("  %-8s %12s %12s %7s\n", "kind", "count", "words", "live%");
+    for (uint32_t k = 0; k < cs.num_kinds; k++) {
+      printf("  %-8s %12llu %12llu %6.1f%%\n", cs.kinds[k].name,
+             (unsigned long long)cs.kinds[k].count,
+             (unsigned long long)cs.kinds[k].words,
+             cs.live_words ? 100.0 * cs.kinds[k].words / cs.live_words : 0.0);
+    }
+  }
+
+#ifdef HVM4_PROFILE
+  if (profile) {
+    FILE *pf = out_path ? fopen(out_path, "w") : stdout;
+    if (!pf) {
+      fprintf(stderr, "cannot write %s\n", out_path);
+    } else {
+      if (!out_path) printf("\n");
+      hvm4_profile_dump(pf, strcmp(profile, "folded") == 0
+                              ? HVM4_PROFILE_FOLDED : HVM4_PROFILE_TABLE);
+      if (out_path) fclose(pf);
+    }
+  }
+  if (folded) {
+    FILE *ff = fopen(folded, "w");
+    if (!ff) {
+      fprintf(stderr, "cannot write %s\n", folded);
+    } else {
+      hvm4_profile_dump(ff, HVM4_PROFILE_FOLDED);
+      fclose(ff);
+    }
+  }
+#endif
+
+  free(out);
+  hvm4_lib_cleanup();
+  return 0;
+}
@@ -0,0 +1,130 @@
+// RSS / heap timeline sampler shared by the bench drivers
+// Include after hvm4_bridge.c. A background thread samples every few
+// milliseconds while the driver evaluates:
+//
+//   t_ms       - milliseconds since mem_sampler_start()
+//   rss_kb     - resident set size (/proc/self/statm)
+//   heap_words - HVM4 heap words in use (allocation cursors of all slices)
+//   itrs       - interactions so far
+//   gc_count   - compactions so far (@gc_tick / %gc_done)
+//
+// mem_sampler_write_csv() writes the series with that header. The cursors
+// and counters are read without synchronization while the workers bump
+// them; a sample can be a few words stale, which is fine for a timeline.
+// A jump in gc_count next to a drop in heap_words marks a compaction.
+
+#ifndef MEM_SAMPLER_H
+#define MEM_SAMPLER_H
+
+typedef struct {
+  double   t_ms;
+  long     rss_kb;
+  uint64_t heap_words;
+  uint64_t itrs;
+  uint64_t gc_count;
+} MemSample;
+
+typedef struct {
+  pthread_t  thread;
+  int        stop;
+  unsigned   period_ms;
+  double     t0;
+  MemSample *samples;
+  size_t     len, cap;
+} MemSampler;
+
+static double mem_sampler_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static long mem_sampler_rss_kb(void) {
+  FILE *f = fopen("/proc/self/statm", "r");
+  long size = 0, resident = 0;
+  if (f) {
+    if (fscanf(f, "%ld %ld", &size, &resident) != 2) resident = 0;
+    fclose(f);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void mem_sampler_take(MemSampler *ms) {
+  if (ms->len == ms->cap) {
+    size_t cap = ms->cap ? ms->cap * 2 : 4096;
+    MemSample *grown = realloc(ms->samples, cap * sizeof(MemSample));
+    if (!grown) return;
+    ms->samples = grown;
+    ms->cap     = cap;
+  }
+  hvm4_stats_t st;
+  hvm4_stats(&st);
+  MemSample *s  = &ms->samples[ms->len++];
+  s->t_ms       = mem_sampler_now_ms() - ms->t0;
+  s->rss_kb     = mem_sampler_rss_kb();
+  s->heap_words = st.heap_words;
+  s->itrs       = st.itrs;
+  s->gc_count   = st.gc_count;
+}
+
+static void *mem_sampler_main(void *arg) {
+  MemSampler *ms = arg;
+  struct timespec period = {
+    .tv_sec  = ms->period_ms / 1000,
+    .tv_nsec = (long)(ms->period_ms % 1000) * 1000000L,
+  };
+  while (!__atomic_load_n(&ms->stop, __ATOMIC_ACQUIRE)) {
+    mem_sampler_take(ms);
+    nanosleep(&period, NULL);
+  }
+  return NULL;
+}
+
+// Starts sampling every period_ms (at least 1). Returns 0, or -1 if the
+// thread could not be created.
+static int mem_sampler_start(MemSampler *ms, unsigned period_ms) {
+  memset(ms, 0, sizeof(*ms));
+  ms->period_ms = period_ms ? period_ms : 1;
+  ms->t0        = mem_sampler_now_ms();
+  return pthread_create(&ms->thread, NULL, mem_sampler_main, ms) == 0 ? 0 : -1;
+}
+
+// Stops the thread and records one final sample (the state at the end).
+static void mem_sampler_stop(MemSampler *ms) {
+  __atomic_store_n(&ms->stop, 1, __ATOMIC_RELEASE);
+  pthread_join(ms->thread, NULL);
+  mem_sampler_take(ms);
+}
+
+static int mem_sampler_write_csv(const MemSampler *ms, const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) return -1;
+  fprintf(f, "t_ms,rss_kb,heap_words,itrs,gc_count\n");
+  for (size_t i = 0; i < ms->len; i++) {
+    const MemSample *s = &ms->samples[i];
+    fprintf(f, "%.2f,%ld,%llu,%llu,%llu\n", s->t_ms, s->rss_kb,
+            (unsigned long long)s->heap_words, (unsigned long long)s->itrs,
+            (unsigned long long)s->gc_count);
+  }
+  return fclose(f) == 0 ? 0 : -1;
+}
+
+// One-line summary: sample count and peaks.
+static void mem_sampler_print(const MemSampler *ms, const char *path) {
+  long     rss  = 0;
+  uint64_t heap = 0;
+  for (size_t i = 0; i < ms->len; i++) {
+    if (ms->samples[i].rss_kb > rss) rss = ms->samples[i].rss_kb;
+    if (ms->samples[i].heap_words > heap) heap = ms->samples[i].heap_words;
+  }
+  printf("Timeline: %zu samples every %u ms -> %s (peak RSS %ld MB, peak heap %llu words)\n",
+         ms->len, ms->period_ms, path, rss / 1024, (unsigned long long)heap);
+}
+
+static void mem_sampler_free(MemSampler *ms) {
+  free(ms->samples);
+  ms->samples = NULL;
+  ms->len = ms->cap = 0;
+}
+
+#endif
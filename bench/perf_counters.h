@@ -0,0 +1,209 @@
+// Hardware performance counters per benchmark phase (perf_event_open)
+// Header-only; shared by bench/hybrid_bf.c, bench/dag_dp.c and
+// lib/benchmark.c. A driver opens the counters once, brackets each phase
+// with perf_begin()/perf_end() and prints the table with perf_print():
+//
+//   Phase     Time (s)     Cycles      Instrs   IPC   LLC miss  dTLB miss  Br miss
+//
+// Counters are user-space only (exclude_kernel/exclude_hv), so they work at
+// perf_event_paranoid <= 2. They inherit into threads created after
+// perf_open(): open them before hvm4_lib_init() to include the workers.
+// Counts are scaled by time_enabled / time_running when the kernel had to
+// multiplex them.
+//
+// Degrades gracefully: a counter the kernel or VM refuses (EACCES, ENOENT,
+// EOPNOTSUPP, ...) prints as "-", and with none available perf_open()
+// returns 0, perf_print() prints one line saying why, and the phase calls
+// only record wall time. Non-Linux builds get the same no-op behaviour.
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+enum {
+  PERF_CYCLES,
+  PERF_INSTRS,
+  PERF_LLC_MISSES,
+  PERF_DTLB_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_NUM
+};
+
+#define PERF_MAX_PHASES 16
+
+typedef struct {
+  const char *name;
+  double      secs;
+  uint64_t    count[PERF_NUM];
+} perf_phase_t;
+
+typedef struct {
+  int          fd[PERF_NUM];   // -1: unavailable
+  int          open;           // number of counters opened
+  int          err;            // errno of the first failed open
+  double       t0;
+  perf_phase_t phase[PERF_MAX_PHASES];
+  int          nphase;
+} perf_counters_t;
+
+static inline double perf_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Counters off: the phase calls only record wall time. For drivers that
+// bracket phases unconditionally and open the counters on request.
+static void perf_off(perf_counters_t *pc) {
+  memset(pc, 0, sizeof(*pc));
+  for (int i = 0; i < PERF_NUM; i++) pc->fd[i] = -1;
+}
+
+#ifdef __linux__
+
+static int perf_open_one(uint32_t type, uint64_t config) {
+  struct perf_event_attr pe;
+  memset(&pe, 0, sizeof(pe));
+  pe.size           = sizeof(pe);
+  pe.type           = type;
+  pe.config         = config;
+  pe.disabled       = 1;
+  pe.inherit        = 1;
+  pe.exclude_kernel = 1;
+  pe.exclude_hv     = 1;
+  pe.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED
+                    | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+// Returns the number of counters opened (0 when perf is not permitted).
+static int perf_open(perf_counters_t *pc) {
+  static const struct { uint32_t type; uint64_t config; } ev[PERF_NUM] = {
+    [PERF_CYCLES]        = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [PERF_INSTRS]        = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [PERF_LLC_MISSES]    = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    [PERF_DTLB_MISSES]   = { PERF_TYPE_HW_CACHE,
+                             PERF_COUNT_HW_CACHE_DTLB
+                             | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                             | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    [PERF_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  };
+  memset(pc, 0, sizeof(*pc));
+  for (int i = 0; i < PERF_NUM; i++) {
+    pc->fd[i] = perf_open_one(ev[i].type, ev[i].config);
+    if (pc->fd[i] >= 0) {
+      pc->open++;
+    } else if (!pc->err) {
+      pc->err = errno;
+    }
+  }
+  return pc->open;
+}
+
+static void perf_begin(perf_counters_t *pc) {
+  for (int i = 0; i < PERF_NUM; i++) {
+    if (pc->fd[i] < 0) continue;
+    ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+  pc->t0 = perf_now();
+}
+
+static void perf_end(perf_counters_t *pc, const char *name) {
+  double t1 = perf_now();
+  perf_phase_t ph = { .name = name, .secs = t1 - pc->t0 };
+  for (int i = 0; i < PERF_NUM; i++) {
+    uint64_t v[3];   // value, time_enabled, time_running
+    ph.count[i] = UINT64_MAX;
+    if (pc->fd[i] < 0) continue;
+    ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    if (read(pc->fd[i], v, sizeof(v)) != (ssize_t)sizeof(v)) continue;
+    ph.count[i] = v[2] && v[2] < v[1]
+                ? (uint64_t)((double)v[0] * v[1] / v[2]) : v[0];
+  }
+  if (pc->nphase < PERF_MAX_PHASES) pc->phase[pc->nphase++] = ph;
+}
+
+static void perf_close(perf_counters_t *pc) {
+  for (int i = 0; i < PERF_NUM; i++) {
+    if (pc->fd[i] >= 0) close(pc->fd[i]);
+    pc->fd[i] = -1;
+  }
+}
+
+#else
+
+static int perf_open(perf_counters_t *pc) {
+  perf_off(pc);
+  return 0;
+}
+
+static void perf_begin(perf_counters_t *pc) {
+  pc->t0 = perf_now();
+}
+
+static void perf_end(perf_counters_t *pc, const char *name) {
+  perf_phase_t ph = { .name = name, .secs = perf_now() - pc->t0 };
+  for (int i = 0; i < PERF_NUM; i++) ph.count[i] = UINT64_MAX;
+  if (pc->nphase < PERF_MAX_PHASES) pc->phase[pc->nphase++] = ph;
+}
+
+static void perf_close(perf_counters_t *pc) {
+  (void)pc;
+}
+
+#endif
+
+static void perf_print_count(uint64_t v) {
+  if (v == UINT64_MAX) {
+    printf(" %11s", "-");
+  } else {
+    printf(" %11llu", (unsigned long long)v);
+  }
+}
+
+static void perf_print(const perf_counters_t *pc) {
+  printf("\n--- Performance counters (user space) ---\n");
+  if (pc->open == 0) {
+#ifdef __linux__
+    printf("unavailable: %s%s\n", pc->err ? strerror(pc->err) : "no counters",
+           pc->err == EACCES || pc->err == EPERM
+             ? " (check /proc/sys/kernel/perf_event_paranoid)"
+             : " (no hardware PMU exposed, e.g. in a VM?)");
+#else
+    printf("unavailable on this platform\n");
+#endif
+  }
+  printf("%-9s %9s %11s %11s %5s %11s %11s %11s\n", "Phase", "Time (s)",
+         "Cycles", "Instrs", "IPC", "LLC miss", "dTLB miss", "Br miss");
+  for (int p = 0; p < pc->nphase; p++) {
+    const perf_phase_t *ph = &pc->phase[p];
+    printf("%-9s %9.3f", ph->name, ph->secs);
+    perf_print_count(ph->count[PERF_CYCLES]);
+    perf_print_count(ph->count[PERF_INSTRS]);
+    uint64_t c = ph->count[PERF_CYCLES], n = ph->count[PERF_INSTRS];
+    if (c != UINT64_MAX && n != UINT64_MAX && c > 0) {
+      printf(" %5.2f", (double)n / (double)c);
+    } else {
+      printf(" %5s", "-");
+    }
+    perf_print_count(ph->count[PERF_LLC_MISSES]);
+    perf_print_count(ph->count[PERF_DTLB_MISSES]);
+    perf_print_count(ph->count[PERF_BRANCH_MISSES]);
+    printf("\n");
+  }
+}
+
+#endif
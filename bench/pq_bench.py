@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""Priority-queue microbenchmarks for the HVM4 heap libraries.
+
+Usage: python3 bench/pq_bench.py [--sizes=250,1000,4000] [--runs=3]
+                                 [--heaps=leftist,pairing,skew,bucket]
+                                 [--traces=sort,dk,dijkstra]
+
+Heaps (all expose the same @pq_* interface):
+  leftist   lib/_pq_lib_.hvm4
+  pairing   lib/_pq_pairing_lib_.hvm4
+  skew      lib/_pq_skew_lib_.hvm4
+  bucket    lib/_pq_bucket_lib_.hvm4 (bucket trie, needs @PQ_HALF)
+
+Traces (N = size):
+  sort      insert N random keys in [0, 4N), then pop all N
+  dk        decrease-key heavy, shaped like Dijkstra: each of N steps pops
+            the minimum and pushes 4 entries at popped + 1..20 for ids drawn
+            from N/4 vertices, so most pushes are lazy decrease-keys of a
+            vertex that is already queued; then the queue is drained
+  dijkstra  the bench/gen.py Dijkstra program (binary trie, adjacency
+            trie) on gen_graph(N, 4) with each heap
+
+The sort and dk programs fold over a list of #I{prio, val} / #D{} ops and
+return a checksum of the popped priorities, so every heap must produce
+the same number. Each program runs through bench/hvm4_bench; the table
+shows interactions per queue operation (the op-list walk is included and
+costs the same for every heap) and the heap words in use after
+evaluation, which is the peak for the bump allocator since nothing is
+compacted. The files are written to a temporary directory.
+"""
+import csv, heapq, io, os, random, subprocess, sys, tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(SCRIPT_DIR)
+sys.path.insert(0, SCRIPT_DIR)
+
+import gen
+
+BENCH = os.path.join(SCRIPT_DIR, "hvm4_bench")
+
+HEAPS = {
+    "leftist": "_pq_lib_.hvm4",
+    "pairing": "_pq_pairing_lib_.hvm4",
+    "skew":    "_pq_skew_lib_.hvm4",
+    "bucket":  "_pq_bucket_lib_.hvm4",
+}
+
+TRACES = ["sort", "dk", "dijkstra"]
+DEFAULT_SIZES = [250, 1000, 4000]
+
+CHECK_MOD = 1000003
+
+RUN_FUNCS = r"""
+@run = λ{
+  []: λheap. λacc. acc;
+  <>: λop. λt. λheap. λacc. @run_op(op, t, heap, acc)
+}
+
+@run_op = λ{
+  #I: λp. λv. λt. λheap. λacc. @run(t, @pq_insert(p, v, heap), acc);
+  #D: λt. λheap. λacc. @run_pop(@pq_pop(heap), t, acc)
+}
+
+@run_pop = λ{
+  #PQE: λt. λacc. @run(t, @pq_empty, acc);
+  #R: λp. λv. λrest. λt. λacc. @run(t, rest, (acc * 31 + p) % 1000003)
+}
+"""
+
+def parse_list(arg, conv=int):
+    return [conv(x) for x in arg.split(",") if x]
+
+def load_heap(name):
+    with open(os.path.join(ROOT, "lib", HEAPS[name])) as f:
+        return f.read()
+
+# ---------- traces ----------
+# An op is ("I", prio, val) or ("D",).
+
+def trace_sort(n, rng):
+    ops = [("I", rng.randrange(4 * n), i) for i in range(n)]
+    return ops + [("D",)] * n
+
+def trace_dk(n, rng):
+    ids = max(1, n // 4)
+    ops, h = [("I", 0, 0)], [0]
+    for _ in range(n):
+        ops.append(("D",))
+        d = heapq.heappop(h)
+        for _ in range(4):
+            p = d + rng.randint(1, 20)
+            ops.append(("I", p, rng.randrange(ids)))
+            heapq.heappush(h, p)
+    return ops + [("D",)] * len(h)
+
+def simulate(ops):
+    """Replay ops on a Python heap: (checksum of popped prios, max prio)."""
+    h, acc, top = [], 0, 0
+    for op in ops:
+        if op[0] == "I":
+            heapq.heappush(h, op[1])
+            top = max(top, op[1])
+        elif h:
+            acc = (acc * 31 + heapq.heappop(h)) % CHECK_MOD
+    return acc, top
+
+def fmt_ops(ops, per_line=16):
+    """(append helper, @ops definition): one list literal, or @append-ed
+    chunks when long."""
+    items = [f"#I{{{op[1]},{op[2]}}}" if op[0] == "I" else "#D{}" for op in ops]
+    def lit(name, xs):
+        lines = ["  " + ", ".join(xs[i:i + per_line])
+                 for i in range(0, len(xs), per_line)]
+        return f"@{name} = [\n" + ",\n".join(lines) + "]"
+    CHUNK = 3000
+    if len(items) <= CHUNK:
+        return "", lit("ops", items)
+    parts = [lit(f"ops_{i}", items[j:j + CHUNK])
+             for i, j in enumerate(range(0, len(items), CHUNK))]
+    expr = f"@ops_{len(parts) - 1}"
+    for i in range(len(parts) - 2, -1, -1):
+        expr = f"@append(@ops_{i}, {expr})"
+    return gen.APPEND_FUNC, "\n\n".join(parts + [f"@ops = {expr}"])
+
+def gen_trace_file(heap, lib, trace, n, ops):
+    check, top = simulate(ops)
+    append_func, ops_str = fmt_ops(ops)
+    half = f"@PQ_HALF = {gen.pq_half(top)}\n" if "@PQ_HALF" in lib else ""
+    nops = len(ops)
+    return f"""// PQ microbenchmark — {heap} — trace={trace}, N={n}, ops={nops}
+// Expected: {check}
+
+{half}{append_func}{lib}
+{ops_str}
+{RUN_FUNCS}
+@main = @run(@ops, @pq_empty, 0)
+//{check}
+""", check, nops
+
+# ---------- running ----------
+
+def build_bench():
+    src = os.path.join(SCRIPT_DIR, "hvm4_bench.c")
+    if os.path.exists(BENCH) and os.path.getmtime(BENCH) >= os.path.getmtime(src):
+        return
+    cc = os.environ.get("CC", "clang")
+    subprocess.run([cc, "-O2", "-o", BENCH, src, "-lpthread"], check=True)
+
+def run_file(path, runs, base):
+    """One hvm4_bench process: (CSV row, heap words), or None when the
+    evaluation failed (heap overflow aborts the process)."""
+    p = subprocess.run([BENCH, f"--runs={runs}", "--format=csv",
+                        f"--write-baseline={base}", path],
+                       cwd=ROOT, capture_output=True, text=True)
+    row = None
+    for r in csv.DictReader(io.StringIO(p.stdout)):
+        if r["file"] == path and r["min_us"]:
+            row = r
+    if row is None or not os.path.exists(base):
+        return None
+    heap_words = "-"
+    with open(base) as f:
+        for line in f:
+            cols = line.rstrip("\n").split("\t")
+            if cols[0] == path:
+                heap_words = cols[5]
+    return row, heap_words
+
+def main():
+    sizes, runs = DEFAULT_SIZES, 3
+    heaps, traces = list(HEAPS), list(TRACES)
+    for a in sys.argv[1:]:
+        k, _, v = a.partition("=")
+        if k == "--sizes":
+            sizes = parse_list(v)
+        elif k == "--runs":
+            runs = int(v)
+        elif k == "--heaps":
+            heaps = parse_list(v, str)
+        elif k == "--traces":
+            traces = parse_list(v, str)
+        else:
+            sys.exit(__doc__)
+    unknown = [h for h in heaps if h not in HEAPS] + \
+              [t for t in traces if t not in TRACES]
+    if unknown:
+        sys.exit(f"unknown heap/trace: {', '.join(unknown)} "
+                 f"(heaps: {', '.join(HEAPS)}; traces: {', '.join(TRACES)})")
+
+    libs = {h: load_heap(h) for h in heaps}
+    for h in heaps:
+        gen.DIJK_PQS.setdefault(h, (f"{h} PQ", libs[h]))
+
+    build_bench()
+    print("Min of", runs, "in-process runs.  Itrs/op = interactions per "
+          "queue operation.  Heap = words in use after evaluation.")
+    with tempfile.TemporaryDirectory(prefix="pq_bench_") as tmp:
+        base = os.path.join(tmp, "baseline.tsv")
+        for trace in traces:
+            for n in sizes:
+                rng = random.Random(42 + n)
+                files = {}
+                if trace == "dijkstra":
+                    edges = gen.gen_graph(n, edges_per_node=4, seed=42 + n)
+                    dist = gen.bellman_ford_py(n, edges)
+                    expect, nops = dist[n - 1], None
+                    for h in heaps:
+                        files[h] = gen.gen_dijk_file(n, edges, dist, h)
+                    desc = f"E={len(edges)}"
+                else:
+                    ops = trace_sort(n, rng) if trace == "sort" else trace_dk(n, rng)
+                    for h in heaps:
+                        files[h], expect, nops = gen_trace_file(h, libs[h], trace, n, ops)
+                    desc = f"ops={nops}"
+                print(f"\n=== {trace} N={n} {desc} ===")
+                print(f"  {'Heap':10s} {'Itrs':>12s} {'Itrs/op':>10s} "
+                      f"{'Time (us)':>12s} {'Heap (W)':>12s}  Check")
+                best = None
+                for h in heaps:
+                    path = os.path.join(tmp, f"pq_{trace}_{h}_{n}.hvm4")
+                    with open(path, "w") as f:
+                        f.write(files[h])
+                    if os.path.exists(base):
+                        os.remove(base)
+                    res = run_file(path, runs, base)
+                    if res is None:
+                        print(f"  {h:10s} {'OOM':>12s}")
+                        continue
+                    row, heap_words = res
+                    itrs = int(row["itrs"])
+                    ok = int(row["first"]) == expect
+                    per_op = f"{itrs / nops:.1f}" if nops else "-"
+                    print(f"  {h:10s} {itrs:12d} {per_op:>10s} "
+                          f"{float(row['min_us']):12.1f} {heap_words:>12s}  "
+                          f"{'PASS' if ok else 'FAIL'}")
+                    if ok and (best is None or itrs < best[1]):
+                        best = (h, itrs)
+                if best:
+                    print(f"  -> {best[0]}")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,72 @@
+// Thread-scaling sweep helpers shared by the bench drivers
+// Include after hvm4_bridge.c. A driver runs the same program once per
+// thread count (hvm4_set_threads + hvm4_lib_reset between runs), records
+// each run with sweep_record() and prints the table with sweep_print():
+//
+//   Threads  Time (s)  Speedup  Eff.  Itrs  max/mean  idle  Check
+//
+// Speedup and efficiency are relative to the first thread count in the list
+// (normally 1). max/mean is the busiest worker's interactions over the
+// average (1.00 = perfectly balanced); idle counts workers that did no
+// interactions at all.
+
+#ifndef THREAD_SWEEP_H
+#define THREAD_SWEEP_H
+
+#define SWEEP_MAX 64
+
+typedef struct {
+  uint32_t threads;
+  double   secs;
+  uint64_t itrs;
+  double   balance;    // max / mean interactions per worker
+  uint32_t idle;       // workers with zero interactions
+  int      ok;         // result matched the reference
+} SweepRow;
+
+// Parses "1,2,4,8" into out[]; returns the number of entries.
+static int sweep_parse_list(const char *s, uint32_t *out, int max) {
+  int n = 0;
+  while (*s && n < max) {
+    char *end;
+    unsigned long v = strtoul(s, &end, 10);
+    if (end == s) break;
+    if (v > 0) out[n++] = (uint32_t)v;
+    s = *end == ',' ? end + 1 : end;
+  }
+  return n;
+}
+
+static void sweep_record(SweepRow *row, double secs, int ok) {
+  uint64_t per[MAX_THREADS];
+  uint32_t n = hvm4_thread_itrs(per, MAX_THREADS);
+  uint64_t sum = 0, max = 0;
+  uint32_t idle = 0;
+  for (uint32_t t = 0; t < n; t++) {
+    sum += per[t];
+    if (per[t] > max) max = per[t];
+    if (per[t] == 0) idle++;
+  }
+  row->threads = n;
+  row->secs    = secs;
+  row->itrs    = sum;
+  row->balance = sum ? (double)max * n / (double)sum : 0.0;
+  row->idle    = idle;
+  row->ok      = ok;
+}
+
+static void sweep_print(uint32_t V, const SweepRow *rows, int n) {
+  printf("\n--- Thread sweep: V=%u ---\n", V);
+  printf("%8s %10s %8s %7s %14s %9s %5s %6s\n", "Threads", "Time (s)",
+         "Speedup", "Eff.", "Itrs", "max/mean", "idle", "Check");
+  for (int i = 0; i < n; i++) {
+    double speedup = rows[i].secs > 0 ? rows[0].secs / rows[i].secs : 0.0;
+    double eff = speedup * rows[0].threads / rows[i].threads;
+    printf("%8u %10.3f %7.2fx %6.0f%% %14llu %9.2f %5u %6s\n",
+           rows[i].threads, rows[i].secs, speedup, eff * 100.0,
+           (unsigned long long)rows[i].itrs, rows[i].balance, rows[i].idle,
+           rows[i].ok ? "PASS" : "FAIL");
+  }
+}
+
+#endif
@@ -1,20 +1,37 @@
 #!/usr/bin/env bash
 # Benchmark radix-16 vs radix-32 trie (and assoc-list where available)
-# at various graph sizes.
+# at various graph sizes, radix 16 with edge-partitioned rounds, plus the
+# linear early-termination tries: binary, radix-4, radix-8, bucketed
+# leaves (8 / 16 values per leaf) and the two adaptive (mixed-radix)
+# layouts. Each size ends with Dijkstra on the leftist heap vs the
+# bucket-trie queue.
 #
 # Usage: ./bench_trie.sh [runs]    (default: 3)
+#
+# The census columns come from one extra in-process run of @bf (@result
+# for Dijkstra) through bench/hvm4_run --census: heap words reachable from
+# the final distance trie, the share of allocated words that is garbage,
+# and the node kind holding the most live words.
 set -euo pipefail
 
 cd "$(dirname "$0")"
 
-HVM=./HVM4/clang/main
+BENCH=./bench/hvm4_bench
+RUN=./bench/hvm4_run
 RUNS="${1:-3}"
 
-if [ ! -x "$HVM" ]; then
-  echo "HVM4 not built. Run ./build.sh first."
+if [ ! -f HVM4/clang/hvm4.c ]; then
+  echo "HVM4 sources missing. Run: git submodule update --init"
   exit 1
 fi
 
+if [ ! -x "$BENCH" ] || [ bench/hvm4_bench.c -nt "$BENCH" ]; then
+  ${CC:-clang} -O2 -o "$BENCH" bench/hvm4_bench.c -lpthread
+fi
+if [ ! -x "$RUN" ] || [ bench/hvm4_run.c -nt "$RUN" ]; then
+  ${CC:-clang} -O2 -o "$RUN" bench/hvm4_run.c -lpthread
+fi
+
 # Generate benchmark files if missing
 if ! ls bench/bf_trie16_*.hvm4 &>/dev/null; then
   echo "Generating benchmark files..."
@@ -39,8 +56,9 @@ done
 # Sort numerically
 IFS=$'\n' SIZES=($(sort -n <<<"${SIZES[*]}")); unset IFS
 
-echo "Bellman-Ford: assoc-list vs radix-16 trie vs radix-32 trie vs linear btrie"
-echo "Best of $RUNS runs.  Itrs = HVM4 interactions.  Time = wall-clock us."
+echo "Bellman-Ford: assoc-list vs radix-16 trie vs radix-32 trie vs linear btrie vs linear ET tries"
+echo "Dijkstra: leftist heap vs bucket-trie priority queue"
+echo "Min of $RUNS in-process runs.  Itrs = HVM4 interactions.  Time = eval us.  RSS = resident growth (KB)."
 echo ""
 
 for sz in "${SIZES[@]}"; do
@@ -51,11 +69,13 @@ for sz in "${SIZES[@]}"; do
   t16_depth=$(head -1 "bench/bf_trie16_${sz}.hvm4" | grep -oP 'depth=\K[0-9]+' || echo "?")
   t32_depth=$(head -1 "bench/bf_trie32_${sz}.hvm4" | grep -oP 'depth=\K[0-9]+' || echo "?")
   bt_depth=$(head -1 "bench/bf_btrie_${sz}.hvm4" | grep -oP 'depth=\K[0-9]+' || echo "?")
+  r8_depth=$(head -1 "bench/bf_r8_et_${sz}.hvm4" 2>/dev/null | grep -oP 'depth=\K[0-9]+' || echo "?")
+  bk16_depth=$(head -1 "bench/bf_bkt16_et_${sz}.hvm4" 2>/dev/null | grep -oP 'depth=\K[0-9]+' || echo "?")
   edges=$(head -1 "bench/bf_trie16_${sz}.hvm4" | grep -oP 'E=\K[0-9]+' || echo "?")
-  printf "(E=%s, r16_depth=%s, r32_depth=%s, bt_depth=%s) ===\n" "$edges" "$t16_depth" "$t32_depth" "$bt_depth"
+  printf "(E=%s, r16_depth=%s, r32_depth=%s, bt_depth=%s, r8_depth=%s, bk16_depth=%s) ===\n" "$edges" "$t16_depth" "$t32_depth" "$bt_depth" "$r8_depth" "$bk16_depth"
 
-  printf "  %-12s %12s %12s %14s %10s\n" "Variant" "Itrs" "Time (us)" "Perf (MIPS)" "RSS (KB)"
-  printf '  %.0s-' {1..64}
+  printf "  %-12s %12s %12s %14s %10s %12s %7s %-14s\n" "Variant" "Itrs" "Time (us)" "Perf (MIPS)" "dRSS (KB)" "Live (W)" "Garb%" "Top node"
+  printf '  %.0s-' {1..100}
   echo ""
 
   FILES=()
@@ -66,49 +86,69 @@ for sz in "${SIZES[@]}"; do
   fi
   FILES+=("bench/bf_trie16_${sz}.hvm4" "bench/bf_trie32_${sz}.hvm4")
   LABELS+=("radix-16" "radix-32")
+  # radix-16 with 16 edge partitions relaxed in parallel and min-merged
+  if [ -f "bench/bf_trie16_par_${sz}.hvm4" ]; then
+    FILES+=("bench/bf_trie16_par_${sz}.hvm4")
+    LABELS+=("r16-par")
+  fi
   if [ -f "bench/bf_btrie_${sz}.hvm4" ]; then
     FILES+=("bench/bf_btrie_${sz}.hvm4")
     LABELS+=("lin-btrie")
   fi
+  # Linear tries with early termination (all stop once a round changes
+  # nothing): binary, radix-4, radix-8, radix-4 over 8- and 16-value leaf
+  # blocks, radix-16 over binary (wide top) and binary over radix-16
+  # (narrow top)
+  for v in btrie_et:btrie-et q4_et:q4-et r8_et:r8-et bkt8_et:bkt8-et bkt16_et:bkt16-et \
+           adapt_wn_et:adapt-wn adapt_nw_et:adapt-nw; do
+    if [ -f "bench/bf_${v%%:*}_${sz}.hvm4" ]; then
+      FILES+=("bench/bf_${v%%:*}_${sz}.hvm4")
+      LABELS+=("${v#*:}")
+    fi
+  done
+  # Dijkstra over the binary trie with the two priority queues
+  for v in dijk_btrie:dijk-leftist dijk_bq:dijk-bucket; do
+    if [ -f "bench/${v%%:*}_${sz}.hvm4" ]; then
+      FILES+=("bench/${v%%:*}_${sz}.hvm4")
+      LABELS+=("${v#*:}")
+    fi
+  done
 
   for idx in "${!FILES[@]}"; do
     f="${FILES[$idx]}"
     label="${LABELS[$idx]}"
 
-    best_us=""
-    best_itrs=""
-    best_perf=""
-    best_rss=""
-
-    for ((r = 1; r <= RUNS; r++)); do
-      t0=$(date +%s%N)
-      raw=$("$HVM" "$f" -s 2>&1) || true
-      t1=$(date +%s%N)
-      wall_us=$(( (t1 - t0) / 1000 ))
-
-      # Check for OOM
-      if echo "$raw" | grep -q "Out of heap"; then
-        best_itrs="OOM"
-        best_us="-"
-        best_perf="-"
-        best_rss="-"
-        break
-      fi
-
-      itrs=$(echo "$raw" | grep -oP 'Itrs: \K[0-9]+' || echo "0")
-      perf=$(echo "$raw" | grep -oP 'Perf: \K[0-9.]+' || echo "0")
-      rss=$( { /usr/bin/time -v "$HVM" "$f" > /dev/null; } 2>&1 | grep -oP 'Maximum resident set size.*: \K[0-9]+' || echo "0")
-
-      if [ -z "$best_us" ] || [ "$wall_us" -lt "$best_us" ]; then
-        best_us="$wall_us"
-        best_itrs="$itrs"
-        best_perf="$perf"
-        best_rss="$rss"
-      fi
-    done
-
-    printf "  %-12s %12s %12s %14s %10s\n" \
-      "$label" "$best_itrs" "$best_us" "$best_perf" "$best_rss"
+    # One in-process harness run per variant: warmup + RUNS timed evals.
+    # A heap overflow aborts the process, which leaves no CSV row.
+    row=$("$BENCH" --runs="$RUNS" --format=csv --no-header "$f" 2>&1) || true
+    if echo "$row" | grep -q "Out of heap" || ! echo "$row" | grep -q "^$f,"; then
+      best_itrs="OOM"
+      best_us="-"
+      best_perf="-"
+      best_rss="-"
+    else
+      IFS=, read -r _ _ min_us _ _ _ _ itrs mips drss _ _ <<<"$(echo "$row" | grep "^$f,")"
+      best_us="${min_us%.*}"
+      best_itrs="$itrs"
+      best_perf="$mips"
+      best_rss="$drss"
+    fi
+
+    live="-"
+    garb="-"
+    top="-"
+    if [ "$best_itrs" != "OOM" ]; then
+      root=bf
+      case "$f" in bench/dijk_*) root=result ;; esac
+      census=$("$RUN" --root="$root" --census "$f" 2>/dev/null) || true
+      live=$(echo "$census" | grep -oP 'Census: live=\K[0-9]+' || echo "-")
+      garb=$(echo "$census" | grep -oP 'garbage=\K[0-9.]+%' || echo "-")
+      top=$(echo "$census" | awk '/^  kind /{getline; printf "%s %s", $1, $4; exit}')
+      top="${top:--}"
+    fi
+
+    printf "  %-12s %12s %12s %14s %10s %12s %7s %-14s\n" \
+      "$label" "$best_itrs" "$best_us" "$best_perf" "$best_rss" "$live" "$garb" "$top"
   done
   echo ""
 done
@@ -0,0 +1,217 @@
+// Native all-pairs shortest paths kernel
+// ======================================
+//
+// Backend for pathfind::algebraic_apsp(g, NATIVE): a cache-blocked
+// Floyd-Warshall over a dense uint32 matrix, with the same n x n row-major
+// output as the HVM4 versions (999999 = unreachable).
+//
+//   apsp_native(row_ptr, col_idx, weight, n, out, threads)
+//
+// The matrix is padded to whole APSP_TILE x APSP_TILE tiles. For each
+// diagonal tile k (Venkataraman, Sahni & Mukhopadhyaya's blocked FW):
+//
+//   1. tile (k,k) closes over itself,
+//   2. the other tiles of row k and column k relax through it,
+//   3. every remaining tile (i,j) takes D[i][j] = min(D[i][j],
+//      D[i][k] + D[k][j]): a min-plus tile product, independent per tile.
+//
+// Phases 2 and 3 are split across threads (tile rows in phase 3), started
+// and joined per phase; phase 1 runs on the calling thread. The tile row
+// relaxation is a branch-free min/add on uint32 lanes (AVX2 where the CPU
+// has it, see APSP_CLONES). A 64 x 64 tile is 16 KB, so the three tiles of
+// a phase-3 product stay in L1/L2.
+//
+// Sums stay below 2^32 as long as path lengths do: INF + INF is 1999998,
+// and since every entry starts at or below INF, a relaxation through an INF
+// entry can never lower anything.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef APSP_TILE
+#define APSP_TILE 64
+#endif
+
+#define APSP_INF 999999u
+
+// x86-64 builds get an AVX2 clone of each tile kernel next to the baseline
+// one, picked once at load time from the CPU (an ifunc), so no -mavx2 is
+// needed. clang vectorizes the row loop at -O2, gcc at -O3 or with
+// -ftree-vectorize.
+#if defined(__x86_64__) && defined(__ELF__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define APSP_CLONES __attribute__((target_clones("avx2", "default")))
+#endif
+#endif
+#ifndef APSP_CLONES
+#define APSP_CLONES
+#endif
+
+// cr[j] = min(cr[j], a + br[j]) over one tile row: branch-free, so it
+// vectorizes to add/min on uint32 lanes. cr and br may be the same row
+// (row k of a phase-2 tile, where a is the diagonal 0).
+static inline void apsp_row_relax(uint32_t *cr, const uint32_t *br, uint32_t a) {
+  for (int j = 0; j < APSP_TILE; j++) {
+    uint32_t s = a + br[j];
+    cr[j] = s < cr[j] ? s : cr[j];
+  }
+}
+
+// Phases 1 and 2: c may alias a (column tile) or b (row tile), so k runs
+// outermost as in plain Floyd-Warshall.
+APSP_CLONES
+static void apsp_tile_fw(uint32_t *c, const uint32_t *a, const uint32_t *b, size_t ld) {
+  for (int k = 0; k < APSP_TILE; k++) {
+    const uint32_t *bk = b + (size_t)k * ld;
+    for (int i = 0; i < APSP_TILE; i++) {
+      uint32_t aik = a[(size_t)i * ld + k];
+      if (aik >= APSP_INF) continue;
+      apsp_row_relax(c + (size_t)i * ld, bk, aik);
+    }
+  }
+}
+
+// Phase 3: c is disjoint from a and b, so i-k-j order keeps row i of c hot
+// and skips whole rows of b when a[i][k] is INF.
+APSP_CLONES
+static void apsp_tile_minplus(uint32_t *c, const uint32_t *a, const uint32_t *b, size_t ld) {
+  for (int i = 0; i < APSP_TILE; i++) {
+    uint32_t *ci = c + (size_t)i * ld;
+    const uint32_t *ai = a + (size_t)i * ld;
+    for (int k = 0; k < APSP_TILE; k++) {
+      if (ai[k] >= APSP_INF) continue;
+      apsp_row_relax(ci, b + (size_t)k * ld, ai[k]);
+    }
+  }
+}
+
+typedef struct {
+  uint32_t *d;        // padded matrix, ld x ld
+  size_t    ld;       // padded size, a multiple of APSP_TILE
+  uint32_t  tiles;    // ld / APSP_TILE
+  uint32_t  threads;
+  uint32_t  k;        // current diagonal tile
+  int       phase;    // 2 or 3
+} apsp_job_t;
+
+typedef struct {
+  apsp_job_t *job;
+  uint32_t    tid;
+} apsp_worker_t;
+
+static inline uint32_t *apsp_tile(apsp_job_t *job, uint32_t ti, uint32_t tj) {
+  return job->d + (size_t)ti * APSP_TILE * job->ld + (size_t)tj * APSP_TILE;
+}
+
+// One thread's share of phase 2 (row and column k tiles, round-robin) or
+// phase 3 (every tile row i = tid, tid + threads, ..).
+static void *apsp_worker(void *arg) {
+  apsp_worker_t *w   = arg;
+  apsp_job_t    *job = w->job;
+  uint32_t       nt  = job->tiles;
+  uint32_t       k   = job->k;
+  uint32_t      *kk  = apsp_tile(job, k, k);
+
+  if (job->phase == 2) {
+    for (uint32_t t = w->tid; t < 2 * nt; t += job->threads) {
+      uint32_t j = t / 2;
+      if (j == k) continue;
+      if (t % 2 == 0) {
+        uint32_t *kj = apsp_tile(job, k, j);
+        apsp_tile_fw(kj, kk, kj, job->ld);
+      } else {
+        uint32_t *jk = apsp_tile(job, j, k);
+        apsp_tile_fw(jk, jk, kk, job->ld);
+      }
+    }
+    return NULL;
+  }
+  for (uint32_t i = w->tid; i < nt; i += job->threads) {
+    if (i == k) continue;
+    const uint32_t *ik = apsp_tile(job, i, k);
+    for (uint32_t j = 0; j < nt; j++) {
+      if (j == k) continue;
+      apsp_tile_minplus(apsp_tile(job, i, j), ik, apsp_tile(job, k, j), job->ld);
+    }
+  }
+  return NULL;
+}
+
+// Runs one phase on job->threads threads and waits for all of them.
+// Shares whose thread could not be started run here afterwards.
+static void apsp_run_phase(apsp_job_t *job, int phase, pthread_t *tids,
+                           apsp_worker_t *workers, int *started) {
+  job->phase = phase;
+  for (uint32_t t = 0; t < job->threads; t++) {
+    workers[t] = (apsp_worker_t){ job, t };
+    started[t] = t > 0 && pthread_create(&tids[t], NULL, apsp_worker, &workers[t]) == 0;
+  }
+  apsp_worker(&workers[0]);
+  for (uint32_t t = 1; t < job->threads; t++) {
+    if (started[t]) pthread_join(tids[t], NULL);
+    else apsp_worker(&workers[t]);
+  }
+}
+
+// Same rule as hvm4_lib_init: HVM4_THREADS, else all online cores.
+static uint32_t apsp_default_threads(void) {
+  const char *env = getenv("HVM4_THREADS");
+  if (env && env[0] && atoi(env) > 0) return (uint32_t)atoi(env);
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  return ncpu > 0 ? (uint32_t)ncpu : 1;
+}
+
+// Shortest distances between all pairs of a CSR graph into out[n * n].
+// threads = 0 picks the default above. Returns 0, or -1 if allocation
+// fails.
+int apsp_native(const uint32_t *row_ptr, const uint32_t *col_idx,
+                const uint32_t *weight, uint32_t n, uint32_t *out,
+                uint32_t threads) {
+  if (n == 0) return 0;
+
+  apsp_job_t job;
+  job.tiles = (n + APSP_TILE - 1) / APSP_TILE;
+  job.ld    = (size_t)job.tiles * APSP_TILE;
+  if (threads == 0) threads = apsp_default_threads();
+  if (threads > job.tiles) threads = job.tiles;
+  job.threads = threads;
+
+  size_t bytes = job.ld * job.ld * sizeof(uint32_t);
+  if (posix_memalign((void **)&job.d, 64, bytes) != 0) return -1;
+  for (size_t i = 0; i < job.ld * job.ld; i++) job.d[i] = APSP_INF;
+  for (size_t i = 0; i < job.ld; i++) job.d[i * job.ld + i] = 0;
+  for (uint32_t u = 0; u < n; u++) {
+    for (uint32_t e = row_ptr[u]; e < row_ptr[u + 1]; e++) {
+      uint32_t *cell = &job.d[(size_t)u * job.ld + col_idx[e]];
+      if (weight[e] < *cell) *cell = weight[e];
+    }
+  }
+
+  pthread_t     *tids    = malloc(threads * sizeof(pthread_t));
+  apsp_worker_t *workers = malloc(threads * sizeof(apsp_worker_t));
+  int           *started = malloc(threads * sizeof(int));
+  int ok = tids && workers && started;
+  if (ok) {
+    for (uint32_t k = 0; k < job.tiles; k++) {
+      uint32_t *kk = apsp_tile(&job, k, k);
+      job.k = k;
+      apsp_tile_fw(kk, kk, kk, job.ld);
+      apsp_run_phase(&job, 2, tids, workers, started);
+      apsp_run_phase(&job, 3, tids, workers, started);
+    }
+  }
+  free(tids);
+  free(workers);
+  free(started);
+
+  if (ok) {
+    for (uint32_t i = 0; i < n; i++) {
+      memcpy(out + (size_t)i * n, job.d + (size_t)i * job.ld, n * sizeof(uint32_t));
+    }
+  }
+  free(job.d);
+  return ok ? 0 : -1;
+}
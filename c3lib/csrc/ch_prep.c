@@ -0,0 +1,521 @@
+// Contraction hierarchy preprocessing
+// ===================================
+//
+// Builds the hierarchy that pathfind::contraction_query searches:
+//
+//   ch_build(row_ptr, col_idx, weight, n, threads) - contract a CSR graph
+//   ch_edge_count(ch, down)                        - size of up / down graph
+//   ch_export(ch, rank, up_*, dn_*)                - copy out ranks and CSRs
+//   ch_free(ch)
+//
+// Contraction runs in rounds. A node's priority is its edge difference
+// (the shortcuts contracting it would add, minus the live edges it would
+// remove) plus the number of its neighbours already contracted, which
+// spreads contraction evenly over the graph. Each round contracts an
+// independent set: every live node whose (priority, hashed id) is below
+// that of all its live neighbours. The set's witness searches run in
+// parallel and treat the whole set as gone, so no witness runs through a
+// node that disappears in the same round. The shortcuts are applied once
+// all searches are done, then the neighbours' priorities are recomputed
+// (in parallel as well).
+//
+// A witness search for u -> v -> x is a Dijkstra from u over the live
+// graph minus v, cut off past the longest u -> v -> x and after
+// CH_SETTLE_LIMIT settled nodes. A search that gives up adds the shortcut:
+// a few more edges, never a wrong distance.
+//
+// Ranks are the contraction order. Every edge, original or shortcut, ends
+// up in exactly one of the two exported graphs:
+//
+//   up    u -> x for rank[u] < rank[x]     (forward search from s)
+//   down  x -> u for rank[u] > rank[x]     (backward search from t, stored
+//                                           reversed so it also climbs)
+//
+// Both are CSR over node ids. Parallel edges keep the lightest weight.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef CH_SETTLE_LIMIT
+#define CH_SETTLE_LIMIT 500
+#endif
+
+// Priority estimates only need the shortcut count roughly right, and run
+// for every neighbour of every contracted node, so they search less.
+#ifndef CH_PRIO_SETTLE_LIMIT
+#define CH_PRIO_SETTLE_LIMIT 20
+#endif
+
+#define CH_INF  0xffffffffu
+#define CH_LIVE 0xffffffffu   // rank of a node not contracted yet
+
+typedef struct {
+  uint32_t to, w;
+} ch_arc_t;
+
+typedef struct {
+  ch_arc_t *a;
+  uint32_t  len, cap;
+} ch_list_t;
+
+typedef struct {
+  uint32_t u, x, w;
+} ch_shortcut_t;
+
+typedef struct {
+  ch_shortcut_t *a;
+  size_t         len, cap;
+} ch_sc_list_t;
+
+// Per-thread witness search state: dist[] is CH_INF except at the nodes
+// listed in touched[], target[x] == stamp marks the nodes the current
+// search still has to reach, and the heap holds (dist, node) with lazy
+// deletion.
+typedef struct {
+  uint32_t *dist;
+  uint32_t *touched;
+  uint32_t  ntouched;
+  uint32_t *target;
+  uint32_t  stamp;
+  uint64_t *heap;       // dist << 32 | node
+  size_t    hlen, hcap;
+  ch_sc_list_t sc;      // shortcuts found by this thread this round
+  int       oom;        // an allocation failed in this thread's share
+} ch_scratch_t;
+
+typedef struct ch_s {
+  uint32_t   n;
+  ch_list_t *out, *in;
+  uint32_t  *rank;      // contraction order, CH_LIVE while live
+  int32_t   *prio;
+  uint32_t  *cn;        // contracted neighbours
+  uint32_t  *mark;      // == round: in this round's independent set
+  uint32_t  *queued;    // == round: queued for a priority update
+  uint32_t   round;
+  uint32_t   threads;
+  ch_scratch_t *scratch;
+  uint32_t   up_m, dn_m;
+} ch_t;
+
+// ---------------------------------------------------------------------------
+// Adjacency
+// ---------------------------------------------------------------------------
+
+static int ch_push(ch_list_t *l, uint32_t to, uint32_t w) {
+  if (l->len == l->cap) {
+    uint32_t cap = l->cap ? l->cap * 2 : 4;
+    ch_arc_t *a = realloc(l->a, cap * sizeof(ch_arc_t));
+    if (!a) return -1;
+    l->a = a;
+    l->cap = cap;
+  }
+  l->a[l->len++] = (ch_arc_t){ to, w };
+  return 0;
+}
+
+// Adds u -> x, or lowers its weight if it is already there.
+static int ch_add_edge(ch_t *ch, uint32_t u, uint32_t x, uint32_t w) {
+  if (u == x) return 0;
+  ch_list_t *o = &ch->out[u];
+  for (uint32_t i = 0; i < o->len; i++) {
+    if (o->a[i].to != x) continue;
+    if (w < o->a[i].w) {
+      o->a[i].w = w;
+      ch_list_t *in = &ch->in[x];
+      for (uint32_t j = 0; j < in->len; j++) {
+        if (in->a[j].to == u) in->a[j].w = w;
+      }
+    }
+    return 0;
+  }
+  if (ch_push(o, x, w) != 0) return -1;
+  return ch_push(&ch->in[x], u, w);
+}
+
+// Drops the arc to v (there is at most one).
+static void ch_unlink(ch_list_t *l, uint32_t v) {
+  for (uint32_t i = 0; i < l->len; i++) {
+    if (l->a[i].to == v) {
+      l->a[i] = l->a[--l->len];
+      return;
+    }
+  }
+}
+
+// Adjacency lists only hold live nodes (see ch_build), so the only nodes
+// to skip are those of the set being contracted.
+static inline int ch_gone(const ch_t *ch, uint32_t v) {
+  return ch->mark[v] == ch->round;
+}
+
+// ---------------------------------------------------------------------------
+// Witness search
+// ---------------------------------------------------------------------------
+
+static int ch_heap_push(ch_scratch_t *s, uint32_t d, uint32_t v) {
+  if (s->hlen == s->hcap) {
+    size_t cap = s->hcap ? s->hcap * 2 : 256;
+    uint64_t *h = realloc(s->heap, cap * sizeof(uint64_t));
+    if (!h) return -1;
+    s->heap = h;
+    s->hcap = cap;
+  }
+  uint64_t item = (uint64_t)d << 32 | v;
+  size_t i = s->hlen++;
+  while (i > 0 && s->heap[(i - 1) / 2] > item) {
+    s->heap[i] = s->heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  s->heap[i] = item;
+  return 0;
+}
+
+static uint64_t ch_heap_pop(ch_scratch_t *s) {
+  uint64_t top  = s->heap[0];
+  uint64_t last = s->heap[--s->hlen];
+  size_t i = 0;
+  for (;;) {
+    size_t c = 2 * i + 1;
+    if (c >= s->hlen) break;
+    if (c + 1 < s->hlen && s->heap[c + 1] < s->heap[c]) c++;
+    if (s->heap[c] >= last) break;
+    s->heap[i] = s->heap[c];
+    i = c;
+  }
+  if (s->hlen > 0) s->heap[i] = last;
+  return top;
+}
+
+static inline void ch_touch(ch_scratch_t *s, uint32_t v, uint32_t d) {
+  if (s->dist[v] == CH_INF) s->touched[s->ntouched++] = v;
+  s->dist[v] = d;
+}
+
+// Distances from u within `limit`, avoiding v and gone nodes; stops once
+// the `targets` marked nodes are all settled. Sets s->oom if the heap
+// cannot grow.
+static void ch_witness(const ch_t *ch, ch_scratch_t *s, uint32_t u, uint32_t v,
+                       uint32_t limit, uint32_t targets, uint32_t max_settled) {
+  s->hlen = 0;
+  ch_touch(s, u, 0);
+  if (ch_heap_push(s, 0, u) != 0) {
+    s->oom = 1;
+    return;
+  }
+  uint32_t settled = 0;
+  while (s->hlen > 0 && settled < max_settled) {
+    uint64_t item = ch_heap_pop(s);
+    uint32_t d = (uint32_t)(item >> 32), y = (uint32_t)item;
+    if (d > s->dist[y]) continue;
+    if (d > limit) break;
+    settled++;
+    if (s->target[y] == s->stamp && --targets == 0) break;
+    const ch_list_t *o = &ch->out[y];
+    for (uint32_t i = 0; i < o->len; i++) {
+      uint32_t z = o->a[i].to;
+      if (z == v || ch_gone(ch, z)) continue;
+      uint32_t nd = d + o->a[i].w;
+      if (nd < s->dist[z]) {
+        ch_touch(s, z, nd);
+        if (ch_heap_push(s, nd, z) != 0) {
+          s->oom = 1;
+          return;
+        }
+      }
+    }
+  }
+}
+
+static void ch_witness_reset(ch_scratch_t *s) {
+  for (uint32_t i = 0; i < s->ntouched; i++) s->dist[s->touched[i]] = CH_INF;
+  s->ntouched = 0;
+}
+
+// Shortcuts needed to contract v: counted, and recorded in s->sc when
+// `record` is set (a real contraction, with the full search budget). A
+// shortcut that cannot be recorded sets s->oom.
+static uint32_t ch_simulate(const ch_t *ch, ch_scratch_t *s, uint32_t v, int record) {
+  uint32_t count = 0;
+  const ch_list_t *in = &ch->in[v], *out = &ch->out[v];
+  for (uint32_t i = 0; i < in->len; i++) {
+    uint32_t u = in->a[i].to, wu = in->a[i].w;
+    if (u == v || ch_gone(ch, u)) continue;
+    uint32_t limit = 0, targets = 0;
+    s->stamp++;
+    for (uint32_t j = 0; j < out->len; j++) {
+      uint32_t x = out->a[j].to;
+      if (x == u || ch_gone(ch, x)) continue;
+      if (wu + out->a[j].w > limit) limit = wu + out->a[j].w;
+      s->target[x] = s->stamp;
+      targets++;
+    }
+    if (targets == 0) continue;
+
+    ch_witness(ch, s, u, v, limit, targets,
+               record ? CH_SETTLE_LIMIT : CH_PRIO_SETTLE_LIMIT);
+    for (uint32_t j = 0; j < out->len; j++) {
+      uint32_t x = out->a[j].to, via = wu + out->a[j].w;
+      if (x == u || ch_gone(ch, x) || s->dist[x] <= via) continue;
+      count++;
+      if (!record) continue;
+      if (s->sc.len == s->sc.cap) {
+        size_t cap = s->sc.cap ? s->sc.cap * 2 : 64;
+        ch_shortcut_t *a = realloc(s->sc.a, cap * sizeof(ch_shortcut_t));
+        if (!a) {
+          s->oom = 1;
+          continue;
+        }
+        s->sc.a = a;
+        s->sc.cap = cap;
+      }
+      s->sc.a[s->sc.len++] = (ch_shortcut_t){ u, x, via };
+    }
+    ch_witness_reset(s);
+  }
+  return count;
+}
+
+static int32_t ch_priority(const ch_t *ch, ch_scratch_t *s, uint32_t v) {
+  int32_t removed = (int32_t)(ch->in[v].len + ch->out[v].len);
+  return (int32_t)ch_simulate(ch, s, v, 0) - removed + (int32_t)ch->cn[v];
+}
+
+// ---------------------------------------------------------------------------
+// Parallel passes over a node list
+// ---------------------------------------------------------------------------
+
+enum { CH_PASS_PRIO, CH_PASS_CONTRACT };
+
+typedef struct {
+  ch_t           *ch;
+  const uint32_t *nodes;
+  uint32_t        count;
+  uint32_t        tid;
+  int             pass;
+} ch_worker_t;
+
+static void *ch_worker(void *arg) {
+  ch_worker_t *w  = arg;
+  ch_t        *ch = w->ch;
+  ch_scratch_t *s = &ch->scratch[w->tid];
+  for (uint32_t i = w->tid; i < w->count; i += ch->threads) {
+    uint32_t v = w->nodes[i];
+    if (w->pass == CH_PASS_PRIO) {
+      ch->prio[v] = ch_priority(ch, s, v);
+    } else {
+      ch_simulate(ch, s, v, 1);
+    }
+  }
+  return NULL;
+}
+
+// Shares whose thread could not be started run on the caller afterwards.
+// Returns -1 if any share ran out of memory.
+static int ch_parallel(ch_t *ch, const uint32_t *nodes, uint32_t count, int pass) {
+  uint32_t    t_n = ch->threads;
+  pthread_t   tids[t_n];
+  ch_worker_t workers[t_n];
+  int         started[t_n];
+  for (uint32_t t = 0; t < t_n; t++) {
+    workers[t] = (ch_worker_t){ ch, nodes, count, t, pass };
+    started[t] = t > 0 && count > t
+              && pthread_create(&tids[t], NULL, ch_worker, &workers[t]) == 0;
+  }
+  ch_worker(&workers[0]);
+  for (uint32_t t = 1; t < t_n; t++) {
+    if (started[t]) pthread_join(tids[t], NULL);
+    else ch_worker(&workers[t]);
+  }
+  int oom = 0;
+  for (uint32_t t = 0; t < t_n; t++) {
+    oom |= ch->scratch[t].oom;
+    ch->scratch[t].oom = 0;
+  }
+  return oom ? -1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Contraction
+// ---------------------------------------------------------------------------
+
+static inline uint32_t ch_hash(uint32_t v) {
+  return v * 2654435761u;
+}
+
+// (priority, hash) of v below that of a
+static inline int ch_before(const ch_t *ch, uint32_t v, uint32_t a) {
+  if (ch->prio[v] != ch->prio[a]) return ch->prio[v] < ch->prio[a];
+  return ch_hash(v) < ch_hash(a);
+}
+
+static int ch_local_min(const ch_t *ch, uint32_t v) {
+  for (uint32_t i = 0; i < ch->out[v].len; i++) {
+    uint32_t a = ch->out[v].a[i].to;
+    if (ch->rank[a] == CH_LIVE && !ch_before(ch, v, a)) return 0;
+  }
+  for (uint32_t i = 0; i < ch->in[v].len; i++) {
+    uint32_t a = ch->in[v].a[i].to;
+    if (ch->rank[a] == CH_LIVE && !ch_before(ch, v, a)) return 0;
+  }
+  return 1;
+}
+
+static uint32_t ch_default_threads(void) {
+  const char *env = getenv("HVM4_THREADS");
+  if (env && env[0] && atoi(env) > 0) return (uint32_t)atoi(env);
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  return ncpu > 0 ? (uint32_t)ncpu : 1;
+}
+
+void ch_free(ch_t *ch) {
+  if (!ch) return;
+  for (uint32_t v = 0; ch->out && ch->in && v < ch->n; v++) {
+    free(ch->out[v].a);
+    free(ch->in[v].a);
+  }
+  for (uint32_t t = 0; ch->scratch && t < ch->threads; t++) {
+    free(ch->scratch[t].dist);
+    free(ch->scratch[t].touched);
+    free(ch->scratch[t].target);
+    free(ch->scratch[t].heap);
+    free(ch->scratch[t].sc.a);
+  }
+  free(ch->out);
+  free(ch->in);
+  free(ch->rank);
+  free(ch->prio);
+  free(ch->cn);
+  free(ch->mark);
+  free(ch->queued);
+  free(ch->scratch);
+  free(ch);
+}
+
+// Contracts the graph; threads = 0 means HVM4_THREADS, else all cores.
+// Returns NULL when out of memory.
+ch_t *ch_build(const uint32_t *row_ptr, const uint32_t *col_idx,
+               const uint32_t *weight, uint32_t n, uint32_t threads) {
+  ch_t *ch = calloc(1, sizeof(ch_t));
+  if (!ch) return NULL;
+  ch->n       = n;
+  ch->threads = threads ? threads : ch_default_threads();
+  size_t nn   = n ? n : 1;
+  ch->out     = calloc(nn, sizeof(ch_list_t));
+  ch->in      = calloc(nn, sizeof(ch_list_t));
+  ch->rank    = malloc(nn * sizeof(uint32_t));
+  ch->prio    = calloc(nn, sizeof(int32_t));
+  ch->cn      = calloc(nn, sizeof(uint32_t));
+  ch->mark    = calloc(nn, sizeof(uint32_t));
+  ch->queued  = calloc(nn, sizeof(uint32_t));
+  ch->scratch = calloc(ch->threads, sizeof(ch_scratch_t));
+  uint32_t *nodes = malloc(nn * sizeof(uint32_t));
+  int ok = ch->out && ch->in && ch->rank && ch->prio && ch->cn && ch->mark
+        && ch->queued && ch->scratch && nodes;
+  for (uint32_t t = 0; ok && t < ch->threads; t++) {
+    ch_scratch_t *s = &ch->scratch[t];
+    s->dist    = malloc(nn * sizeof(uint32_t));
+    s->touched = malloc(nn * sizeof(uint32_t));
+    s->target  = calloc(nn, sizeof(uint32_t));
+    ok = s->dist && s->touched && s->target;
+    if (ok) memset(s->dist, 0xff, nn * sizeof(uint32_t));
+  }
+  for (uint32_t v = 0; ok && v < n; v++) {
+    ch->rank[v] = CH_LIVE;
+    for (uint32_t e = row_ptr[v]; ok && e < row_ptr[v + 1]; e++) {
+      ok = ch_add_edge(ch, v, col_idx[e], weight[e]) == 0;
+    }
+  }
+  if (!ok) {
+    free(nodes);
+    ch_free(ch);
+    return NULL;
+  }
+
+  // Initial priorities. mark[] starts at 0 and rounds count from 1, so no
+  // node is in a set yet.
+  ch->round = 1;
+  for (uint32_t v = 0; v < n; v++) nodes[v] = v;
+  ok = ch_parallel(ch, nodes, n, CH_PASS_PRIO) == 0;
+
+  uint32_t next_rank = 0;
+  for (; ok && next_rank < n; ch->round++) {
+    // Independent set: live local minima
+    uint32_t count = 0;
+    for (uint32_t v = 0; v < n; v++) {
+      if (ch->rank[v] == CH_LIVE && ch_local_min(ch, v)) nodes[count++] = v;
+    }
+    for (uint32_t i = 0; i < count; i++) ch->mark[nodes[i]] = ch->round;
+
+    for (uint32_t t = 0; t < ch->threads; t++) ch->scratch[t].sc.len = 0;
+    ok = ch_parallel(ch, nodes, count, CH_PASS_CONTRACT) == 0;
+
+    for (uint32_t i = 0; i < count; i++) ch->rank[nodes[i]] = next_rank++;
+    for (uint32_t t = 0; ok && t < ch->threads; t++) {
+      ch_sc_list_t *sc = &ch->scratch[t].sc;
+      for (size_t i = 0; ok && i < sc->len; i++) {
+        ok = ch_add_edge(ch, sc->a[i].u, sc->a[i].x, sc->a[i].w) == 0;
+      }
+    }
+
+    // Unlink the set from its neighbours, which are all live: a contracted
+    // node keeps exactly its edges to higher ranks. Each neighbour gets one
+    // more contracted neighbour and a fresh priority; the set is contracted
+    // by now, so no node counts as marked while the priorities run.
+    uint32_t nupd = 0;
+    uint32_t *upd = nodes + count;
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t v = nodes[i];
+      for (int dir = 0; dir < 2; dir++) {
+        const ch_list_t *l = dir ? &ch->in[v] : &ch->out[v];
+        for (uint32_t j = 0; j < l->len; j++) {
+          uint32_t a = l->a[j].to;
+          ch_unlink(dir ? &ch->out[a] : &ch->in[a], v);
+          ch->cn[a]++;
+          if (ch->queued[a] == ch->round) continue;
+          ch->queued[a] = ch->round;
+          upd[nupd++] = a;
+        }
+      }
+    }
+    ok = ok && ch_parallel(ch, upd, nupd, CH_PASS_PRIO) == 0;
+  }
+  free(nodes);
+  if (!ok) {
+    ch_free(ch);
+    return NULL;
+  }
+
+  for (uint32_t v = 0; v < n; v++) {
+    ch->up_m += ch->out[v].len;
+    ch->dn_m += ch->in[v].len;
+  }
+  return ch;
+}
+
+uint32_t ch_edge_count(const ch_t *ch, int down) {
+  return down ? ch->dn_m : ch->up_m;
+}
+
+// rank[n], *_row[n + 1], *_col / *_w sized by ch_edge_count.
+void ch_export(const ch_t *ch, uint32_t *rank,
+               uint32_t *up_row, uint32_t *up_col, uint32_t *up_w,
+               uint32_t *dn_row, uint32_t *dn_col, uint32_t *dn_w) {
+  uint32_t n = ch->n;
+  memcpy(rank, ch->rank, n * sizeof(uint32_t));
+  up_row[0] = dn_row[0] = 0;
+  for (uint32_t v = 0; v < n; v++) {
+    up_row[v + 1] = up_row[v] + ch->out[v].len;
+    dn_row[v + 1] = dn_row[v] + ch->in[v].len;
+    for (uint32_t i = 0; i < ch->out[v].len; i++) {
+      up_col[up_row[v] + i] = ch->out[v].a[i].to;
+      up_w[up_row[v] + i]   = ch->out[v].a[i].w;
+    }
+    for (uint32_t i = 0; i < ch->in[v].len; i++) {
+      dn_col[dn_row[v] + i] = ch->in[v].a[i].to;
+      dn_w[dn_row[v] + i]   = ch->in[v].a[i].w;
+    }
+  }
+}
@@ -0,0 +1,120 @@
+// Loop compaction policy shared by hvm4_bridge.c and lib/libhvm4_graph.c
+// Include after hvm4.c (uses HEAP_BANKS, wnf and prim_register).
+//
+// A polling loop passes its state through %gc_poll once per round: the
+// primitive forces the state and answers 1 when the policy wants a
+// compaction, in which case the state goes through %compact and then
+// %gc_done, which books how many heap words were given back. Rounds are a
+// sequential chain, so the counters are only touched by one thread at a time.
+//
+// Each worker thread bumps its own heap slice (HEAP_BANKS[t].next); usage is
+// measured against the slice starts recorded by heap_mark_bases() after
+// heap_init_slices().
+//
+// Modes:
+//   GC_MODE_OFF   - never compact
+//   GC_MODE_EVERY - compact every `param` rounds
+//   GC_MODE_HEAP  - compact once `param` words were allocated since the last
+//                   compaction (or since the program started)
+//
+// The includer may define GC_MODE_DEFAULT (GC_MODE_OFF otherwise). Polling
+// makes a loop strict in its state, which changes what it costs, so
+// generators emit polling @repeat loops only when gc_polling() says a policy
+// other than off was set through gc_set_policy() or HVM4_GC.
+
+#ifndef GC_POLICY_H
+#define GC_POLICY_H
+
+#define GC_MODE_OFF   0
+#define GC_MODE_EVERY 1
+#define GC_MODE_HEAP  2
+
+#ifndef GC_MODE_DEFAULT
+#define GC_MODE_DEFAULT GC_MODE_OFF
+#endif
+
+static int      gc_mode  = GC_MODE_DEFAULT;
+static uint64_t gc_param = 1;
+static int      gc_explicit;    // set by gc_set_policy
+static uint64_t gc_round;
+static uint64_t gc_mark;        // heap usage after the last compaction
+static uint64_t gc_before;      // heap usage when the pending one started
+static uint64_t gc_count;
+static uint64_t gc_reclaimed;
+static uint64_t heap_base[MAX_THREADS];
+
+static void heap_mark_bases(void) {
+  for (u32 t = 0; t < MAX_THREADS; t++) {
+    heap_base[t] = HEAP_BANKS[t].next;
+  }
+}
+
+// Heap words in use across all worker slices.
+static uint64_t heap_used(void) {
+  uint64_t used = 0;
+  u32 n = thread_get_count();
+  for (u32 t = 0; t < n; t++) {
+    used += HEAP_BANKS[t].next - heap_base[t];
+  }
+  return used;
+}
+
+static void gc_set_policy(int mode, uint64_t param) {
+  gc_mode     = mode;
+  gc_param    = param > 0 ? param : 1;
+  gc_explicit = 1;
+}
+
+static int gc_polling(void) {
+  return gc_explicit && gc_mode != GC_MODE_OFF;
+}
+
+// HVM4_GC=off|every:N|heap:WORDS
+static void gc_policy_from_env(void) {
+  const char *env = getenv("HVM4_GC");
+  if (!env || !env[0]) return;
+  if (strcmp(env, "off") == 0) {
+    gc_set_policy(GC_MODE_OFF, 0);
+  } else if (strncmp(env, "every:", 6) == 0) {
+    gc_set_policy(GC_MODE_EVERY, strtoull(env + 6, NULL, 10));
+  } else if (strncmp(env, "heap:", 5) == 0) {
+    gc_set_policy(GC_MODE_HEAP, strtoull(env + 5, NULL, 10));
+  }
+}
+
+// %gc_poll(state) → NUM: 1 if this round should compact, else 0
+static Term prim_gc_poll(Term *args) {
+  wnf(args[0]);
+  gc_round++;
+  uint64_t used = heap_used();
+  int go = 0;
+  switch (gc_mode) {
+    case GC_MODE_EVERY: go = gc_round % gc_param == 0; break;
+    case GC_MODE_HEAP:  go = used - gc_mark >= gc_param; break;
+    default:            go = 0; break;
+  }
+  if (go) gc_before = used;
+  return term_new_num(go);
+}
+
+// %gc_done(x) → x: runs the pending compaction and books its result
+static Term prim_gc_done(Term *args) {
+  Term x = wnf(args[0]);
+  uint64_t used = heap_used();
+  gc_count++;
+  if (used < gc_before) gc_reclaimed += gc_before - used;
+  gc_mark = used;
+  return x;
+}
+
+// Resets the per-program counters and (re)registers the primitives.
+static void gc_prims_register(void) {
+  gc_round     = 0;
+  gc_mark      = 0;
+  gc_count     = 0;
+  gc_reclaimed = 0;
+  prim_register("gc_poll", 7, 1, prim_gc_poll);
+  prim_register("gc_done", 7, 1, prim_gc_done);
+}
+
+#endif
@@ -2,14 +2,33 @@
 // ======================
 //
 // This file wraps the HVM4 runtime (which uses `#define fn static inline` for
-// all functions) and exports four non-static entry points callable from C3:
+// all functions) and exports non-static entry points callable from C3:
 //
-//   hvm4_lib_init()    - allocate BOOK/HEAP/TABLE, init primitives
-//   hvm4_lib_cleanup() - free all runtime memory
-//   hvm4_lib_reset()   - reset state between evaluations
-//   hvm4_run()         - parse source, evaluate @main, extract numeric results
+//   hvm4_lib_init()      - allocate BOOK/HEAP/TABLE, init primitives
+//   hvm4_lib_cleanup()   - free all runtime memory
+//   hvm4_lib_reset()     - reset state between evaluations
+//   hvm4_run()           - parse source, evaluate @main, extract numeric results
+//   hvm4_parse()         - parse source only (first half of hvm4_run)
+//   hvm4_graph_setup()   - expose a CSR graph as %graph_deg/target/weight
+//   hvm4_memo_setup()    - expose a uint32 array as %memo_get/%memo_set
+//   hvm4_eval()          - evaluate @main, extract numeric results
+//   hvm4_eval_def()      - same, for any named definition
+//   hvm4_extract()       - extract numeric results of the last evaluation
+//   hvm4_snapshot_save() - dump the parsed program (BOOK/TABLE/static HEAP)
+//   hvm4_snapshot_load() - restore a dumped program instead of parsing
+//   hvm4_snapshot_id()   - program id for the two above (FNV-1a of a key)
+//   hvm4_gc_policy()     - choose when loops compact (off/every-N/heap)
+//   hvm4_gc_polling()    - whether @repeat-style loops should poll it
+//   hvm4_stats()         - interactions, heap usage and compaction counters
+//   hvm4_set_threads()   - worker count for the next program (at reset)
+//   hvm4_thread_itrs()   - per-thread interaction counts of the last run
+//   hvm4_trie_radix()    - tuned distance-trie radix for a graph size
+//   hvm4_census()        - live heap words per node kind of the last result
+//   hvm4_profile_dump()  - per-definition profile (-DHVM4_PROFILE builds)
 
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <unistd.h>
 
@@ -18,6 +37,80 @@
 
 #include "../../HVM4/clang/hvm4.c"
 
+// Normal form of the last normalize-mode evaluation (read by hvm4_census).
+static Term g_last_result;
+static int  g_last_result_ok;
+
+static void snap_unmap(void);
+#ifdef HVM4_PROFILE
+static void prof_prims_register(void);
+#endif
+
+// ---------------------------------------------------------------------------
+// Compaction policy: when @gc_tick runs %compact
+// ---------------------------------------------------------------------------
+//
+// heap_init_slices() hands every worker thread a contiguous slice of HEAP;
+// heap_mark_bases() records the slice starts. Parsing runs on thread 0, so
+// the parsed program lives in [heap_base[0], next) of slice 0.
+//
+// The frontier and hybrid Bellman-Ford loops (@bf_loop, @fr_loop) pass their
+// state through @gc_tick once per round. Generators emit GC_TICK_DEFS:
+//
+//   @gc_tick    = λ&s. @gc_tick_go(%gc_poll(s), s)
+//   @gc_tick_go = λ{0: λs. s; λn. λs. %gc_done(%compact(s))}
+//
+// The primitives and counters are shared with lib/libhvm4_graph.c
+// (gc_policy.h). @gc_tick compacts every round unless told otherwise;
+// @repeat and the APSP squaring loop only poll once a policy other than
+// off was set (hvm4_gc_polling), so by default they stay lazy.
+//
+// Policy (hvm4_gc_policy, or HVM4_GC=off|every:N|heap:WORDS at init):
+//   HVM4_GC_OFF   - never compact
+//   HVM4_GC_EVERY - compact every `param` rounds (default: every round)
+//   HVM4_GC_HEAP  - compact once `param` words were allocated since the last
+//                   compaction (or since the program started)
+
+#define GC_MODE_DEFAULT GC_MODE_EVERY
+#include "gc_policy.h"
+
+#define HVM4_GC_OFF   GC_MODE_OFF
+#define HVM4_GC_EVERY GC_MODE_EVERY
+#define HVM4_GC_HEAP  GC_MODE_HEAP
+
+typedef struct {
+  uint64_t itrs;          // interactions, summed over all threads
+  uint64_t heap_words;    // heap words in use, summed over all slices
+  uint64_t gc_count;      // compactions triggered by %gc_poll
+  uint64_t gc_reclaimed;  // heap words given back by those compactions
+} hvm4_stats_t;
+
+// Heap words in use across all worker slices.
+uint64_t hvm4_heap_used(void) {
+  return heap_used();
+}
+
+void hvm4_gc_policy(int mode, uint64_t param) {
+  gc_set_policy(mode, param);
+}
+
+// 1 if generators should emit the polling @repeat / @sq_loop.
+int hvm4_gc_polling(void) {
+  return gc_polling();
+}
+
+// Counters for the program evaluated since the last hvm4_lib_reset().
+void hvm4_stats(hvm4_stats_t *out) {
+  u64 itrs = 0;
+  for (u32 t = 0; t < MAX_THREADS; t++) {
+    itrs += WNF_ITRS_BANKS[t].itrs;
+  }
+  out->itrs         = itrs;
+  out->heap_words   = heap_used();
+  out->gc_count     = gc_count;
+  out->gc_reclaimed = gc_reclaimed;
+}
+
 // ---------------------------------------------------------------------------
 // hvm4_lib_init: one-time runtime initialization
 // ---------------------------------------------------------------------------
@@ -34,6 +127,9 @@ void hvm4_lib_init(void) {
     long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
     threads = ncpu > 0 ? (u32)ncpu : 1;
   }
+#ifdef HVM4_PROFILE
+  threads = 1; // %prof frames read thread 0's interaction counter
+#endif
   thread_set_count(threads); // clamps to [1, MAX_THREADS]
   wnf_set_tid(0);
   BOOK  = calloc(BOOK_CAP, sizeof(u32));
@@ -44,17 +140,84 @@ void hvm4_lib_init(void) {
     exit(1);
   }
   heap_init_slices();
+  heap_mark_bases();
   prim_init();
+  gc_policy_from_env();
+  gc_prims_register();
+#ifdef HVM4_PROFILE
+  prof_prims_register();
+#endif
   DEBUG        = 0;
   SILENT       = 0;
   STEPS_ENABLE = 0;
 }
 
+// ---------------------------------------------------------------------------
+// Thread count: change between programs, read per-thread work afterwards
+// ---------------------------------------------------------------------------
+
+// Worker threads for the next program. Takes effect at the next
+// hvm4_lib_reset(), which re-slices HEAP for the new count.
+void hvm4_set_threads(uint32_t n) {
+#ifdef HVM4_PROFILE
+  n = 1; // %prof frames read thread 0's interaction counter
+#endif
+  thread_set_count(n); // clamps to [1, MAX_THREADS]
+}
+
+uint32_t hvm4_get_threads(void) {
+  return thread_get_count();
+}
+
+// Copies each worker's interaction count for the last evaluation into out[]
+// (at most max entries). Returns the number of worker threads.
+uint32_t hvm4_thread_itrs(uint64_t *out, uint32_t max) {
+  u32 n = thread_get_count();
+  for (u32 t = 0; t < n && t < max; t++) {
+    out[t] = WNF_ITRS_BANKS[t].itrs;
+  }
+  return n;
+}
+
+// ---------------------------------------------------------------------------
+// Trie radix tuning: which distance-trie radix a generator should emit
+// ---------------------------------------------------------------------------
+//
+// The decision table and its lookup live in trie_tuning.h, shared with
+// lib/libhvm4_graph.c. It comes from hvm4_trie_tuning_load() or, on first
+// use, from HVM4_TRIE_TUNING=FILE.
+
+#include "trie_tuning.h"
+
+static int g_tuning_env_done;
+
+// Loads a decision table, replacing the current one; NULL clears it.
+// Returns the number of rows, or -1 if the file cannot be read (the current
+// table is kept).
+int hvm4_trie_tuning_load(const char *path) {
+  g_tuning_env_done = 1;
+  return trie_tuning_read(path);
+}
+
+// Tuned radix for an n-node graph: a power of two in [2, 16], `fallback`
+// (rounded the same way) without a table.
+uint32_t hvm4_trie_radix(uint32_t n, uint32_t fallback) {
+  if (!g_tuning_env_done) {
+    g_tuning_env_done = 1;
+    const char *env = getenv("HVM4_TRIE_TUNING");
+    if (env && env[0] && trie_tuning_read(env) < 0) {
+      fprintf(stderr, "HVM4_TRIE_TUNING: cannot read %s\n", env);
+    }
+  }
+  return trie_tuning_radix(n, fallback);
+}
+
 // ---------------------------------------------------------------------------
 // hvm4_lib_cleanup: free all runtime memory (call once at shutdown)
 // ---------------------------------------------------------------------------
 void hvm4_lib_cleanup(void) {
   wnf_stack_free();
+  snap_unmap();
   free(HEAP);
   free(BOOK);
   // Free TABLE string entries
@@ -81,6 +244,7 @@ void hvm4_lib_reset(void) {
   memset(BOOK, 0, BOOK_CAP * sizeof(u32));
 
   // Reset heap: use madvise to release physical pages without unmapping
+  snap_unmap();
   madvise(HEAP, HEAP_CAP * sizeof(Term), MADV_DONTNEED);
 
   // Reset free lists (stale entries would point to zeroed pages)
@@ -88,6 +252,7 @@ void hvm4_lib_reset(void) {
 
   // Re-initialize heap slices
   heap_init_slices();
+  heap_mark_bases();
 
   // Free PARSE_SEEN_FILES entries (they are strdup'd)
   for (u32 i = 0; i < PARSE_SEEN_FILES_LEN; i++) {
@@ -113,6 +278,11 @@ void hvm4_lib_reset(void) {
   // Clear primitive definitions and re-register (table was cleared)
   memset(PRIM_DEFS, 0, sizeof(PRIM_DEFS));
   prim_init();
+  gc_prims_register();
+#ifdef HVM4_PROFILE
+  prof_prims_register();
+#endif
+  g_last_result_ok = 0;
 }
 
 // ---------------------------------------------------------------------------
@@ -162,71 +332,511 @@ void hvm4_graph_setup(uint32_t *row_ptr, uint32_t *col_idx,
 }
 
 // ---------------------------------------------------------------------------
-// extract_nums: recursively extract NUM values from a result term
+// Memo FFI: caller-owned uint32 array readable/writable from HVM4
+// ---------------------------------------------------------------------------
+//
+// Lets a program keep one value per node outside the heap, e.g. DAG-DP in
+// reverse topological order: each node reads its successors' distances with
+// %memo_get and stores its own with %memo_set. Out-of-range indices read 0
+// and are not written.
+
+static uint32_t *g_memo;
+static uint32_t  g_memo_len;
+
+// %memo_get(i) → NUM: memo[i]
+static Term prim_memo_get(Term *args) {
+  uint32_t i = term_val(wnf(args[0]));
+  return term_new_num(i < g_memo_len ? g_memo[i] : 0);
+}
+
+// %memo_set(i, x) → NUM i: forces x and stores it in memo[i]
+static Term prim_memo_set(Term *args) {
+  uint32_t i = term_val(wnf(args[0]));
+  uint32_t x = term_val(wnf(args[1]));
+  if (i < g_memo_len) g_memo[i] = x;
+  return term_new_num(i);
+}
+
+// Called AFTER hvm4_lib_reset(), BEFORE hvm4_parse()
+void hvm4_memo_setup(uint32_t *memo, uint32_t len) {
+  g_memo     = memo;
+  g_memo_len = len;
+  prim_register("memo_get", 8, 1, prim_memo_get);
+  prim_register("memo_set", 8, 2, prim_memo_set);
+}
+
+// ---------------------------------------------------------------------------
+// extract_nums: extract NUM values from a result term, left to right
 // ---------------------------------------------------------------------------
 //
 // - NUM  (tag 30)         -> extract term_val() as a single value
-// - C02  (tag 15)         -> cons cell, recurse head and tail
-// - C00  (tag 13)         -> empty list, stop
-// - other Cxx             -> recurse into all children
+// - C00  (tag 13)         -> empty list / nullary constructor, nothing
+// - C01..C16              -> visit all children in field order (a cons
+//                            cell is head, then tail)
+//
+// Iterative with an explicit stack: a cons list of V results or a tree
+// holding a full distance vector streams out in order without recursing
+// once per element on the C stack. Children are pushed in reverse so they
+// pop left to right; a list's stack stays at two entries.
 //
 // Returns the next write position (i.e. count of values written so far).
 static int extract_nums(Term term, uint32_t *out, int pos, int max_out) {
-  u8 tag = term_tag(term);
+  size_t cap = 256, len = 0;
+  Term  *stack = malloc(cap * sizeof(Term));
+  if (!stack) return pos;
+  stack[len++] = term;
+
+  while (len > 0) {
+    Term t   = stack[--len];
+    u8   tag = term_tag(t);
 
-  if (tag == NUM) {
-    if (pos < max_out) {
-      out[pos] = term_val(term);
+    if (tag == NUM) {
+      if (pos < max_out) {
+        out[pos] = term_val(t);
+      }
+      pos++;
+      continue;
     }
-    return pos + 1;
+    if (tag < C01 || tag > C16) continue;
+
+    u32 ari = tag - C00;
+    u32 loc = term_val(t);
+    if (len + ari > cap) {
+      cap *= 2;
+      Term *grown = realloc(stack, cap * sizeof(Term));
+      if (!grown) break;
+      stack = grown;
+    }
+    for (u32 i = ari; i-- > 0;) stack[len++] = HEAP[loc + i];
   }
 
-  if (tag == C00) {
-    // Empty list / nullary constructor - nothing to extract
-    return pos;
+  free(stack);
+  return pos;
+}
+
+// ---------------------------------------------------------------------------
+// Profiler: interactions and time per definition (HVM4_PROFILE builds only)
+// ---------------------------------------------------------------------------
+//
+// Built with -DHVM4_PROFILE, hvm4_parse() rewrites every top-level definition
+// so its body runs inside a %prof frame before handing the source to the
+// parser:
+//
+//   @f = λa. λb. BODY            @f = λa. λb. %prof(ID, BODY
+//                          →     )
+//   @g = λ{0: A; λn. B}          @g = λ_p0. λ_p1. %prof(ID, λ{0: A; λn. B}(_p0, _p1)
+//                                )
+//
+// where ID is @f's TABLE id. Matcher bodies are eta-expanded (one argument
+// for the scrutinee plus the lambdas of the first numeric/list branch) so the
+// frame opens when the match fires rather than when the REF is unfolded. The
+// closing paren goes on its own line so trailing `//` comments stay harmless.
+//
+// %prof(id, x) forces x in a nested wnf() and charges the interactions and
+// wall time spent there to `id`. Exclusive ("self") counts subtract nested
+// frames; inclusive ("total") counts are only taken at the outermost frame
+// of a definition, so recursion is not counted twice. Frames also build a
+// call tree (recursive calls fold into the ancestor frame of the same id)
+// used for collapsed-stack output. Frames deeper than PROF_MAX_DEPTH are
+// counted but not timed: their body is handed back unevaluated so deep
+// recursion does not grow the C stack. The profiler reads thread 0's
+// interaction bank, so profiling builds run single-threaded.
+
+#ifdef HVM4_PROFILE
+#include <time.h>
+
+#define PROF_MAX_DEPTH 512
+#define PROF_ROOT      0xFFFFFFFF
+
+#define HVM4_PROFILE_TABLE  0
+#define HVM4_PROFILE_FOLDED 1
+
+typedef struct {
+  u64 calls;
+  u64 self_itrs, total_itrs;
+  u64 self_ns,   total_ns;
+  u32 active;    // frames of this definition currently open
+} ProfDef;
+
+typedef struct {
+  u32 def;       // TABLE id, PROF_ROOT for the root node
+  u32 parent;
+  u32 child;     // first child, 0 = none (node 0 is the root)
+  u32 next;      // next sibling
+  u64 self_itrs;
+} ProfNode;
+
+typedef struct {
+  u32 def;
+  u32 node;
+  u64 t0, i0;
+  u64 child_ns, child_itrs;
+} ProfFrame;
+
+static ProfDef   *g_prof_defs;
+static u32        g_prof_defs_cap;
+static ProfNode  *g_prof_nodes;
+static u32        g_prof_nodes_len;
+static u32        g_prof_nodes_cap;
+static ProfFrame  g_prof_stack[PROF_MAX_DEPTH];
+static u32        g_prof_depth;
+
+static inline u64 prof_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+static void prof_reset(void) {
+  free(g_prof_defs);
+  free(g_prof_nodes);
+  g_prof_defs      = NULL;
+  g_prof_defs_cap  = 0;
+  g_prof_nodes_cap = 64;
+  g_prof_nodes     = calloc(g_prof_nodes_cap, sizeof(ProfNode));
+  g_prof_nodes[0]  = (ProfNode){ .def = PROF_ROOT };
+  g_prof_nodes_len = 1;
+  g_prof_depth     = 0;
+}
+
+static ProfDef *prof_def(u32 id) {
+  if (id >= g_prof_defs_cap) {
+    u32 cap = g_prof_defs_cap ? g_prof_defs_cap : 256;
+    while (cap <= id) cap *= 2;
+    g_prof_defs = realloc(g_prof_defs, cap * sizeof(ProfDef));
+    memset(g_prof_defs + g_prof_defs_cap, 0,
+           (cap - g_prof_defs_cap) * sizeof(ProfDef));
+    g_prof_defs_cap = cap;
   }
+  return &g_prof_defs[id];
+}
 
-  if (tag == C02) {
-    // Cons cell: head at HEAP[val+0], tail at HEAP[val+1]
-    u32 loc  = term_val(term);
-    Term head = HEAP[loc];
-    Term tail = HEAP[loc + 1];
-    pos = extract_nums(head, out, pos, max_out);
-    return extract_nums(tail, out, pos, max_out);
+// Call-tree node for entering `id` under the current frame.
+static u32 prof_node_enter(u32 id) {
+  for (u32 d = g_prof_depth; d > 0; d--) {
+    if (g_prof_stack[d - 1].def == id) return g_prof_stack[d - 1].node;
   }
+  u32 parent = g_prof_depth ? g_prof_stack[g_prof_depth - 1].node : 0;
+  for (u32 c = g_prof_nodes[parent].child; c; c = g_prof_nodes[c].next) {
+    if (g_prof_nodes[c].def == id) return c;
+  }
+  if (g_prof_nodes_len == g_prof_nodes_cap) {
+    g_prof_nodes_cap *= 2;
+    g_prof_nodes = realloc(g_prof_nodes, g_prof_nodes_cap * sizeof(ProfNode));
+  }
+  u32 n = g_prof_nodes_len++;
+  g_prof_nodes[n] = (ProfNode){
+    .def = id, .parent = parent, .next = g_prof_nodes[parent].child,
+  };
+  g_prof_nodes[parent].child = n;
+  return n;
+}
 
-  // For any other constructor with children, try to extract from them
-  if (tag >= C01 && tag <= C16) {
-    u32 ari = tag - C00;
-    u32 loc = term_val(term);
-    for (u32 i = 0; i < ari; i++) {
-      pos = extract_nums(HEAP[loc + i], out, pos, max_out);
+// %prof(id, x) → x, charging the work of forcing x to definition `id`
+static Term prim_prof(Term *args) {
+  u32 id = term_val(wnf(args[0]));
+  ProfDef *d = prof_def(id);
+  d->calls++;
+  if (g_prof_depth == PROF_MAX_DEPTH) {
+    return args[1];
+  }
+  ProfFrame *f = &g_prof_stack[g_prof_depth];
+  f->def        = id;
+  f->node       = prof_node_enter(id);
+  f->child_ns   = 0;
+  f->child_itrs = 0;
+  f->i0         = WNF_ITRS_BANKS[0].itrs;
+  f->t0         = prof_now();
+  g_prof_depth++;
+  d->active++;
+
+  Term r = wnf(args[1]);
+
+  u64 dt = prof_now() - f->t0;
+  u64 di = WNF_ITRS_BANKS[0].itrs - f->i0;
+  g_prof_depth--;
+  d = prof_def(id);
+  d->active--;
+  d->self_ns   += dt - f->child_ns;
+  d->self_itrs += di - f->child_itrs;
+  if (d->active == 0) {
+    d->total_ns   += dt;
+    d->total_itrs += di;
+  }
+  g_prof_nodes[f->node].self_itrs += di - f->child_itrs;
+  if (g_prof_depth > 0) {
+    g_prof_stack[g_prof_depth - 1].child_ns   += dt;
+    g_prof_stack[g_prof_depth - 1].child_itrs += di;
+  }
+  return r;
+}
+
+static void prof_prims_register(void) {
+  prof_reset();
+  prim_register("prof", 4, 2, prim_prof);
+}
+
+// -- Source instrumentation -------------------------------------------------
+
+typedef struct {
+  char  *buf;
+  size_t len, cap;
+} ProfBuf;
+
+static void pb_put(ProfBuf *b, const char *s, size_t n) {
+  if (b->len + n + 1 > b->cap) {
+    while (b->len + n + 1 > b->cap) b->cap = b->cap ? b->cap * 2 : 4096;
+    b->buf = realloc(b->buf, b->cap);
+  }
+  memcpy(b->buf + b->len, s, n);
+  b->len += n;
+  b->buf[b->len] = '\0';
+}
+
+static void pb_str(ProfBuf *b, const char *s) {
+  pb_put(b, s, strlen(s));
+}
+
+static int prof_is_name(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '$';
+}
+
+static int prof_is_lam(const char *p) {
+  return (u8)p[0] == 0xCE && (u8)p[1] == 0xBB;  // UTF-8 'λ'
+}
+
+// Skips whitespace and `//` comments.
+static size_t prof_skip(const char *s, size_t i, size_t end) {
+  while (i < end) {
+    if (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r') {
+      i++;
+    } else if (s[i] == '/' && i + 1 < end && s[i + 1] == '/') {
+      while (i < end && s[i] != '\n') i++;
+    } else {
+      break;
     }
-    return pos;
   }
+  return i;
+}
 
-  return pos;
+// If s[i..] is a binder `λx.` / `λ&x.`, returns the index past the dot.
+static size_t prof_binder(const char *s, size_t i, size_t end) {
+  if (i + 2 >= end || !prof_is_lam(s + i)) return 0;
+  size_t j = i + 2;
+  if (s[j] == '&') j++;
+  size_t name = j;
+  while (j < end && prof_is_name(s[j]) && s[j] != '.') j++;
+  if (j == name || j >= end || s[j] != '.') return 0;
+  return j + 1;
+}
+
+// Index of the `}` closing the `{` at s[i], or 0.
+static size_t prof_close(const char *s, size_t i, size_t end) {
+  int depth = 0;
+  for (; i < end; i++) {
+    if (s[i] == '/' && i + 1 < end && s[i + 1] == '/') {
+      while (i < end && s[i] != '\n') i++;
+    } else if (s[i] == '{') {
+      depth++;
+    } else if (s[i] == '}' && --depth == 0) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+// Arguments a matcher body `λ{…}` at s[i] takes before its first branch
+// yields a value: the scrutinee, plus the branch's own lambdas when the first
+// key is a number or `[]` (constructor branches bind their fields instead).
+static u32 prof_matcher_arity(const char *s, size_t i, size_t end) {
+  size_t k = prof_skip(s, i + 3, end);
+  size_t key = k;
+  while (k < end && s[k] != ':' && s[k] != ';' && s[k] != '}') k++;
+  if (k >= end || s[k] != ':') return 1;
+  int numeric = s[key] == '[' || (s[key] >= '0' && s[key] <= '9');
+  if (!numeric) return 1;
+  u32 ari = 1;
+  size_t j = prof_skip(s, k + 1, end);
+  for (size_t n; (n = prof_binder(s, j, end)); j = prof_skip(s, n, end)) {
+    ari++;
+  }
+  return ari;
+}
+
+// Wraps one definition body s[beg..end) (the text after `=`) in %prof.
+static void prof_wrap(ProfBuf *b, const char *s, size_t beg, size_t end,
+                      u32 id) {
+  // Trim trailing blank and comment-only lines: they stay after the paren.
+  size_t last = end;
+  for (size_t i = beg; i < end; ) {
+    size_t eol = i;
+    while (eol < end && s[eol] != '\n') eol++;
+    size_t t = i;
+    while (t < eol && (s[t] == ' ' || s[t] == '\t' || s[t] == '\r')) t++;
+    if (t < eol && !(s[t] == '/' && t + 1 < eol && s[t + 1] == '/')) {
+      last = eol;
+    }
+    i = eol + 1;
+  }
+  if (last == end && prof_skip(s, beg, end) == end) {
+    pb_put(b, s + beg, end - beg);
+    return;
+  }
+
+  // Leading binders stay outside the frame.
+  size_t i = prof_skip(s, beg, last);
+  for (size_t n; (n = prof_binder(s, i, last)); i = prof_skip(s, n, last)) {}
+  pb_put(b, s + beg, i - beg);
+
+  char tmp[64];
+  size_t close = 0;
+  u32 ari = 0;
+  if (prof_is_lam(s + i) && i + 2 < last && s[i + 2] == '{') {
+    close = prof_close(s, i + 2, last);
+    if (close && prof_skip(s, close + 1, last) < last) close = 0;
+  }
+  if (close) {
+    ari = prof_matcher_arity(s, i, last);
+    for (u32 a = 0; a < ari; a++) {
+      snprintf(tmp, sizeof(tmp), "λ_p%u. ", a);
+      pb_str(b, tmp);
+    }
+  }
+  snprintf(tmp, sizeof(tmp), "%%prof(%u, ", id);
+  pb_str(b, tmp);
+  if (close) {
+    pb_put(b, s + i, close + 1 - i);
+    pb_str(b, "(");
+    for (u32 a = 0; a < ari; a++) {
+      snprintf(tmp, sizeof(tmp), a ? ", _p%u" : "_p%u", a);
+      pb_str(b, tmp);
+    }
+    pb_str(b, ")");
+    pb_put(b, s + close + 1, last - close - 1);
+  } else {
+    pb_put(b, s + i, last - i);
+  }
+  pb_str(b, "\n)");
+  pb_put(b, s + last, end - last);
+}
+
+// Returns a malloc'd copy of `src` with every top-level definition wrapped.
+static char *prof_instrument(const char *src) {
+  ProfBuf b = {0};
+  size_t len = strlen(src);
+  size_t i = 0;
+  pb_put(&b, "", 0);
+  while (i < len) {
+    // A definition starts at column 0: `@name =`
+    size_t eol = i;
+    while (eol < len && src[eol] != '\n') eol++;
+    size_t n = i + 1;
+    while (n < len && prof_is_name(src[n])) n++;
+    size_t eq = n;
+    while (eq < eol && (src[eq] == ' ' || src[eq] == '\t')) eq++;
+    int is_def = src[i] == '@' && n > i + 1 && eq < eol && src[eq] == '=' &&
+                 (eq + 1 >= len || src[eq + 1] != '=');
+    if (!is_def) {
+      pb_put(&b, src + i, (eol < len ? eol + 1 : eol) - i);
+      i = eol + 1;
+      continue;
+    }
+    // Body runs until the next line starting with '@' or '#'.
+    size_t end = eol;
+    while (end < len) {
+      size_t nx = end + 1;
+      if (nx >= len || src[nx] == '@' || src[nx] == '#') break;
+      end = nx;
+      while (end < len && src[end] != '\n') end++;
+    }
+    u32 id = table_find(src + i + 1, (u32)(n - i - 1));
+    pb_put(&b, src + i, eq + 1 - i);
+    prof_wrap(&b, src, eq + 1, end, id);
+    if (end < len) pb_put(&b, "\n", 1);
+    i = end + 1;
+  }
+  return b.buf;
+}
+
+// -- Report -----------------------------------------------------------------
+
+static const ProfDef *g_prof_sort_defs;
+
+static int prof_cmp(const void *a, const void *b) {
+  u64 x = g_prof_sort_defs[*(const u32 *)a].self_itrs;
+  u64 y = g_prof_sort_defs[*(const u32 *)b].self_itrs;
+  return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void prof_folded_path(FILE *out, u32 n) {
+  if (g_prof_nodes[n].parent != 0) {
+    prof_folded_path(out, g_prof_nodes[n].parent);
+    fputc(';', out);
+  }
+  fputs(TABLE[g_prof_nodes[n].def], out);
+}
+
+// Writes the profile of the last evaluation to `out`.
+//   HVM4_PROFILE_TABLE  - one row per definition, sorted by self interactions
+//   HVM4_PROFILE_FOLDED - collapsed stacks ("a;b;c N", N = self interactions),
+//                         the input format of flamegraph.pl / speedscope
+void hvm4_profile_dump(FILE *out, int format) {
+  if (format == HVM4_PROFILE_FOLDED) {
+    for (u32 n = 1; n < g_prof_nodes_len; n++) {
+      if (g_prof_nodes[n].self_itrs == 0) continue;
+      prof_folded_path(out, n);
+      fprintf(out, " %llu\n", (unsigned long long)g_prof_nodes[n].self_itrs);
+    }
+    return;
+  }
+
+  u32 *order = malloc((g_prof_defs_cap + 1) * sizeof(u32));
+  u32 len = 0;
+  u64 sum = 0;
+  for (u32 id = 0; id < g_prof_defs_cap && id < TABLE_LEN; id++) {
+    if (g_prof_defs[id].calls == 0) continue;
+    order[len++] = id;
+    sum += g_prof_defs[id].self_itrs;
+  }
+  g_prof_sort_defs = g_prof_defs;
+  qsort(order, len, sizeof(u32), prof_cmp);
+
+  fprintf(out, "%14s %6s %14s %12s %10s %10s  %s\n", "self itrs", "self%",
+          "total itrs", "calls", "self ms", "total ms", "definition");
+  for (u32 k = 0; k < len; k++) {
+    const ProfDef *d = &g_prof_defs[order[k]];
+    fprintf(out, "%14llu %5.1f%% %14llu %12llu %10.2f %10.2f  @%s\n",
+            (unsigned long long)d->self_itrs,
+            sum ? 100.0 * (double)d->self_itrs / (double)sum : 0.0,
+            (unsigned long long)d->total_itrs,
+            (unsigned long long)d->calls,
+            (double)d->self_ns / 1e6, (double)d->total_ns / 1e6,
+            TABLE[order[k]]);
+  }
+  free(order);
 }
+#endif
 
 // ---------------------------------------------------------------------------
-// hvm4_run: parse source, evaluate @main, extract numeric results
+// hvm4_parse: parse source into BOOK/TABLE/HEAP without evaluating
 // ---------------------------------------------------------------------------
 //
-// Parameters:
-//   source         - HVM4 source code (null-terminated)
-//   collapse_limit - if >0, use eval_collapse; otherwise eval_normalize
-//   out            - output buffer for extracted uint32 values
-//   max_out        - capacity of the output buffer
-//
-// Returns:
-//   >= 0  number of values written to `out`
-//   -1    on error (allocation failure or @main not defined)
-int hvm4_run(const char *source, int collapse_limit, uint32_t *out, int max_out) {
+// Returns 0 on success, -1 on allocation failure or if @main is not defined.
+// Call after hvm4_lib_reset() (and hvm4_graph_setup(), if the program uses
+// the graph primitives).
+int hvm4_parse(const char *source) {
   // Copy source (parser needs a mutable buffer)
+#ifdef HVM4_PROFILE
+  char *src = prof_instrument(source);
+  if (!src) return -1;
+  size_t src_len = strlen(src);
+#else
   size_t src_len = strlen(source);
   char *src = malloc(src_len + 1);
   if (!src) return -1;
   memcpy(src, source, src_len + 1);
+#endif
 
   // Parse
   PState s = {
@@ -245,9 +855,37 @@ int hvm4_run(const char *source, int collapse_limit, uint32_t *out, int max_out)
   if (BOOK[main_id] == 0) {
     return -1;
   }
+  return 0;
+}
 
-  Term main_ref = term_new_ref(main_id);
+// ---------------------------------------------------------------------------
+// hvm4_eval: evaluate the loaded @main, extract numeric results
+// ---------------------------------------------------------------------------
+//
+// Parameters:
+//   collapse_limit - if >0, use eval_collapse; otherwise eval_normalize
+//   out            - output buffer for extracted uint32 values
+//   max_out        - capacity of the output buffer
+//
+// Returns:
+//   >= 0  number of values written to `out`
+//   -1    on error (no program loaded)
+//
+// hvm4_eval_def() evaluates @name instead of @main (e.g. @bf, to inspect the
+// whole distance trie rather than one looked-up entry).
+//
+// In normalize mode `out` may be NULL: the result is only normalized (and
+// 0 returned), and hvm4_extract() reads it afterwards. This lets drivers
+// time evaluation and extraction separately.
+int hvm4_eval_def(const char *name, int collapse_limit, uint32_t *out,
+                  int max_out) {
+  u32 def_id = table_find(name, (u32)strlen(name));
+  if (BOOK[def_id] == 0) {
+    return -1;
+  }
 
+  g_last_result_ok = 0;
+  Term def_ref = term_new_ref(def_id);
   if (collapse_limit > 0) {
     // Collapse mode: force single-threaded for stdout→memstream safety.
     // Worker threads would write to the redirected stdout concurrently,
@@ -263,7 +901,7 @@ int hvm4_run(const char *source, int collapse_limit, uint32_t *out, int max_out)
     FILE *old_stdout = stdout;
     stdout = memf;
 
-    eval_collapse(main_ref, collapse_limit, 0, 0);
+    eval_collapse(def_ref, collapse_limit, 0, 0);
 
     fflush(memf);
     stdout = old_stdout;
@@ -295,7 +933,453 @@ int hvm4_run(const char *source, int collapse_limit, uint32_t *out, int max_out)
     return count;
   } else {
     // Normalize mode: evaluate and extract from term tree
-    Term result = eval_normalize(main_ref);
-    return extract_nums(result, out, 0, max_out);
+    Term result = eval_normalize(def_ref);
+    g_last_result    = result;
+    g_last_result_ok = 1;
+    return out ? extract_nums(result, out, 0, max_out) : 0;
+  }
+}
+
+// Numeric results of the last normalize-mode evaluation, as hvm4_eval()
+// would have returned them. -1 if there is none.
+int hvm4_extract(uint32_t *out, int max_out) {
+  if (!g_last_result_ok) return -1;
+  return extract_nums(g_last_result, out, 0, max_out);
+}
+
+int hvm4_eval(int collapse_limit, uint32_t *out, int max_out) {
+  return hvm4_eval_def("main", collapse_limit, out, max_out);
+}
+
+// ---------------------------------------------------------------------------
+// hvm4_run: parse source, evaluate @main, extract numeric results
+// ---------------------------------------------------------------------------
+//
+// Parameters:
+//   source         - HVM4 source code (null-terminated)
+//   collapse_limit - if >0, use eval_collapse; otherwise eval_normalize
+//   out            - output buffer for extracted uint32 values
+//   max_out        - capacity of the output buffer
+//
+// Returns:
+//   >= 0  number of values written to `out`
+//   -1    on error (allocation failure or @main not defined)
+int hvm4_run(const char *source, int collapse_limit, uint32_t *out, int max_out) {
+  if (hvm4_parse(source) < 0) {
+    return -1;
   }
+  return hvm4_eval(collapse_limit, out, max_out);
+}
+
+// ---------------------------------------------------------------------------
+// Heap census: what the result of the last evaluation is made of
+// ---------------------------------------------------------------------------
+//
+// hvm4_census() walks the normal form left by the last normalize-mode
+// hvm4_eval()/hvm4_eval_def() and counts every heap node reachable from it,
+// grouped by kind: one entry per constructor name (#Q, #QL, #B, #P, ...) plus
+// one per non-constructor tag (lam, sup, dup, ...). NUM, ERA and nullary
+// constructors are unboxed, so they are counted with zero words; nullary
+// constructors still get one entry per name, so empty subtrees (#QE{},
+// #BE{}) and list ends show up next to the nodes that hold them. Shared
+// boxed nodes are visited once.
+//
+// live_words is the total size of those nodes; everything else that was
+// allocated since the program was loaded (hvm4_heap_used) is garbage that
+// the allocator has not reclaimed. Run it with hvm4_eval_def("bf", ...) to
+// see the shape of a whole distance trie rather than one looked-up entry.
+
+#define HVM4_CENSUS_KINDS 32
+
+typedef struct {
+  char     name[8];     // "#QL", "lam", "sup", ...
+  uint64_t count;       // nodes of this kind
+  uint64_t words;       // heap words they occupy
+} hvm4_census_kind_t;
+
+typedef struct {
+  uint64_t live_words;      // heap words reachable from the result
+  uint64_t heap_words;      // heap words in use (live + garbage)
+  uint64_t garbage_words;
+  uint32_t num_kinds;       // entries used in kinds[], sorted by words
+  hvm4_census_kind_t kinds[HVM4_CENSUS_KINDS];
+} hvm4_census_t;
+
+// Constructor names are stored in ext as a 24-bit nick: up to 4 characters,
+// 6 bits each, in the alphabet below (same encoding as variable names, see
+// bench/dag_dp.c). Longer names keep their last 4 characters.
+static void census_ctr_name(u32 nick, char *buf) {
+  static const char B64[64] =
+    "_abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789$";
+  char tmp[4];
+  int n = 0;
+  while (nick && n < 4) {
+    tmp[n++] = B64[nick & 63];
+    nick >>= 6;
+  }
+  buf[0] = '#';
+  for (int i = 0; i < n; i++) buf[1 + i] = tmp[n - 1 - i];
+  buf[1 + n] = '\0';
+}
+
+// Heap words owned by a node of this tag, or -1 if it does not point to one.
+static int census_words(u8 tag) {
+  if (tag >= C01 && tag <= C16) return tag - C00;
+  switch (tag) {
+    case LAM: return 1;
+    case APP: case SUP: case OP2: return 2;
+    case DP0: case DP1: return 1;  // the shared DUP cell
+    default: return -1;
+  }
+}
+
+static const char *census_tag_name(u8 tag) {
+  switch (tag) {
+    case NUM: return "num";
+    case ERA: return "era";
+    case LAM: return "lam";
+    case APP: return "app";
+    case SUP: return "sup";
+    case OP2: return "op2";
+    case DP0: case DP1: return "dup";
+    case VAR: return "var";
+    case REF: return "ref";
+    default:  return "other";
+  }
+}
+
+static void census_count(hvm4_census_t *c, const char *name, u64 words) {
+  u32 k = 0;
+  while (k < c->num_kinds && strcmp(c->kinds[k].name, name) != 0) k++;
+  if (k == c->num_kinds) {
+    if (k == HVM4_CENSUS_KINDS) k--;  // overflow folds into the last slot
+    else c->num_kinds++;
+    snprintf(c->kinds[k].name, sizeof(c->kinds[k].name), "%s", name);
+  }
+  c->kinds[k].count++;
+  c->kinds[k].words += words;
+}
+
+static int census_cmp(const void *a, const void *b) {
+  u64 x = ((const hvm4_census_kind_t *)a)->words;
+  u64 y = ((const hvm4_census_kind_t *)b)->words;
+  return x < y ? 1 : x > y ? -1 : 0;
+}
+
+// Returns 0 on success, -1 if there is no normalized result to inspect or
+// the walk runs out of memory (*out is then cleared, not a partial count).
+int hvm4_census(hvm4_census_t *out) {
+  memset(out, 0, sizeof(*out));
+  if (!g_last_result_ok) return -1;
+
+  // One bit per heap word; untouched pages of the mapping are never backed.
+  size_t bits_len = HEAP_CAP / 8;
+  u8 *seen = mmap(NULL, bits_len, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (seen == MAP_FAILED) return -1;
+
+  size_t cap = 1 << 16, len = 0;
+  Term *stack = malloc(cap * sizeof(Term));
+  if (!stack) { munmap(seen, bits_len); return -1; }
+  stack[len++] = g_last_result;
+
+  char name[8];
+  while (len > 0) {
+    Term t = stack[--len];
+    u8 tag = term_tag(t);
+    int words = census_words(tag);
+    if (words < 0) {
+      if (tag == C00) {
+        census_ctr_name(term_ext(t), name);  // #QE{}, #BE{}, [], ...
+        census_count(out, name, 0);
+      } else if (tag != VAR) {
+        census_count(out, census_tag_name(tag), 0);
+      }
+      continue;
+    }
+    u32 loc = term_val(t);
+    if (seen[loc >> 3] & (1 << (loc & 7))) continue;
+    seen[loc >> 3] |= 1 << (loc & 7);
+
+    if (tag >= C01 && tag <= C16) {
+      census_ctr_name(term_ext(t), name);
+      census_count(out, name, (u64)words);
+    } else {
+      census_count(out, census_tag_name(tag), (u64)words);
+    }
+    out->live_words += (u64)words;
+
+    if (len + (size_t)words > cap) {
+      cap *= 2;
+      Term *grown = realloc(stack, cap * sizeof(Term));
+      if (!grown) {
+        free(stack);
+        munmap(seen, bits_len);
+        memset(out, 0, sizeof(*out));
+        return -1;
+      }
+      stack = grown;
+    }
+    for (int i = words - 1; i >= 0; i--) stack[len++] = HEAP[loc + i];
+  }
+  free(stack);
+  munmap(seen, bits_len);
+
+  out->heap_words    = hvm4_heap_used();
+  out->garbage_words = out->heap_words > out->live_words
+                     ? out->heap_words - out->live_words : 0;
+  qsort(out->kinds, out->num_kinds, sizeof(out->kinds[0]), census_cmp);
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Program snapshots: dump the parsed program, restore it without parsing
+// ---------------------------------------------------------------------------
+//
+// File layout (native endianness, same build of the runtime on both ends):
+//
+//   SnapHeader
+//   book_len  x (u32 id, u32 loc)     - non-empty BOOK entries
+//   table_len x (u32 len, len bytes)  - TABLE names in id order
+//   zero padding up to heap_off
+//   (heap_hi - heap_lo) x Term        - static HEAP region of slice 0
+//
+// heap_off is chosen so that the heap words sit at the same offset within a
+// page as they do in memory. When the fresh runtime places the region at the
+// same location (the common case), whole pages are mmap'd straight into HEAP
+// copy-on-write and only the partial first/last pages are copied, so loading
+// a 10M-edge program costs page faults rather than a parse.
+//
+// If slice 0 starts elsewhere, every heap pointer is shifted while copying.
+// The TABLE prefix created by prim_init()/hvm4_graph_setup() must match the
+// one at save time, so register the same primitives before loading.
+//
+// prog_id identifies the program: callers pass the same id to save and load,
+// typically hvm4_snapshot_id() over their generator parameters (or the
+// source), and a file saved for another program is rejected. Loading checks
+// the whole file before it touches TABLE, HEAP or BOOK, so a rejected
+// snapshot leaves the runtime ready for hvm4_parse().
+
+#define SNAP_MAGIC "HVM4SNP2"
+
+typedef struct {
+  char magic[8];
+  u32  table_len;
+  u32  book_len;
+  u64  heap_lo;
+  u64  heap_hi;
+  u64  heap_off;
+  u64  fresh;
+  u32  fresh_lab;
+  u32  reserved;
+  u64  prog_id;
+} SnapHeader;
+
+// Pages of HEAP currently backed by a snapshot file (see hvm4_lib_reset).
+static void  *g_snap_map;
+static size_t g_snap_map_len;
+
+// Terms whose val field is a heap location (everything but immediates).
+static inline int snap_term_has_loc(Term t) {
+  u8 tag = term_tag(t);
+  return tag != NUM && tag != REF && tag != ERA && tag != C00;
+}
+
+// val occupies the low 32 bits of a Term (sub:1 | tag:7 | ext:24 | val:32).
+static inline Term snap_relocate(Term t, int64_t delta) {
+  if (delta == 0 || !snap_term_has_loc(t)) return t;
+  return (t & ~(Term)0xFFFFFFFF) | (Term)(u32)((int64_t)term_val(t) + delta);
+}
+
+// Drop the file-backed pages so HEAP is plain zero-fill anonymous memory
+// again; MADV_DONTNEED alone would re-read the snapshot contents.
+static void snap_unmap(void) {
+  if (!g_snap_map) return;
+  mmap(g_snap_map, g_snap_map_len, PROT_READ | PROT_WRITE,
+       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+  g_snap_map     = NULL;
+  g_snap_map_len = 0;
+}
+
+// FNV-1a of `len` bytes at `key`: a program id for save/load.
+uint64_t hvm4_snapshot_id(const void *key, size_t len) {
+  const u8 *p = key;
+  u64 h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// Call after hvm4_parse(). Returns 0 on success, -1 on I/O error.
+int hvm4_snapshot_save(const char *path, uint64_t prog_id) {
+  u64 lo = heap_base[0];
+  u64 hi = HEAP_BANKS[0].next;
+
+  u32 book_len = 0;
+  u64 table_bytes = 0;
+  for (u32 i = 0; i < TABLE_LEN; i++) {
+    if (BOOK[i] != 0) book_len++;
+    table_bytes += sizeof(u32) + strlen(TABLE[i]);
+  }
+
+  long page = sysconf(_SC_PAGESIZE);
+  u64 meta = sizeof(SnapHeader) + (u64)book_len * 2 * sizeof(u32) + table_bytes;
+  u64 want = (uintptr_t)&HEAP[lo] % (u64)page;
+  u64 off  = (meta + page - 1) / page * page + want;
+  if (off - page >= meta) off -= page;
+
+  SnapHeader hdr = {
+    .table_len = TABLE_LEN,
+    .book_len  = book_len,
+    .heap_lo   = lo,
+    .heap_hi   = hi,
+    .heap_off  = off,
+    .fresh     = (u64)FRESH,
+    .fresh_lab = PARSE_FRESH_LAB,
+    .prog_id   = prog_id,
+  };
+  memcpy(hdr.magic, SNAP_MAGIC, 8);
+
+  FILE *f = fopen(path, "wb");
+  if (!f) return -1;
+  int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+  for (u32 i = 0; ok && i < TABLE_LEN; i++) {
+    if (BOOK[i] == 0) continue;
+    u32 pair[2] = { i, BOOK[i] };
+    ok = fwrite(pair, sizeof(pair), 1, f) == 1;
+  }
+  for (u32 i = 0; ok && i < TABLE_LEN; i++) {
+    u32 len = (u32)strlen(TABLE[i]);
+    ok = fwrite(&len, sizeof(len), 1, f) == 1
+      && fwrite(TABLE[i], 1, len, f) == len;
+  }
+  for (u64 i = meta; ok && i < off; i++) {
+    ok = fputc(0, f) != EOF;
+  }
+  if (ok && hi > lo) {
+    ok = fwrite(&HEAP[lo], sizeof(Term), hi - lo, f) == hi - lo;
+  }
+  if (fclose(f) != 0) ok = 0;
+  return ok ? 0 : -1;
+}
+
+// Call after hvm4_lib_reset() (and hvm4_graph_setup(), if the program used
+// the graph primitives), in place of hvm4_parse(). Returns 0 on success,
+// -1 if the file is unreadable, belongs to another program (prog_id) or was
+// written by an incompatible setup; the runtime is left untouched then.
+int hvm4_snapshot_load(const char *path, uint64_t prog_id) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (u64)st.st_size < sizeof(SnapHeader)) {
+    close(fd);
+    return -1;
+  }
+  size_t size = (size_t)st.st_size;
+  u8 *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) { close(fd); return -1; }
+
+  int rc = -1;
+  SnapHeader hdr;
+  memcpy(&hdr, map, sizeof(hdr));
+  u64 words    = hdr.heap_hi - hdr.heap_lo;
+  u64 book_end = sizeof(hdr) + (u64)hdr.book_len * 2 * sizeof(u32);
+  if (memcmp(hdr.magic, SNAP_MAGIC, 8) != 0
+   || hdr.prog_id != prog_id
+   || hdr.heap_hi < hdr.heap_lo
+   || hdr.heap_off + words * sizeof(Term) != size
+   || hdr.table_len > BOOK_CAP
+   || hdr.table_len < TABLE_LEN
+   || hdr.book_len > hdr.table_len
+   || book_end > hdr.heap_off) {
+    goto done;
+  }
+
+  // Everything is checked before anything is written.
+  // TABLE: names in id order; the ones already interned must match.
+  const u8 *names = map + book_end;
+  const u8 *end   = map + hdr.heap_off;
+  const u8 *p     = names;
+  for (u32 i = 0; i < hdr.table_len; i++) {
+    u32 len;
+    if (p + sizeof(len) > end) goto done;
+    memcpy(&len, p, sizeof(len));
+    p += sizeof(len);
+    if (len > (u64)(end - p)) goto done;
+    if (i < TABLE_LEN
+     && (strlen(TABLE[i]) != len || memcmp(TABLE[i], p, len) != 0)) {
+      goto done;
+    }
+    p += len;
+  }
+
+  // BOOK: ids name table entries, roots lie in the saved region.
+  const u32 *book = (const u32 *)(map + sizeof(hdr));
+  for (u32 i = 0; i < hdr.book_len; i++) {
+    u32 id  = book[2 * i];
+    u32 loc = book[2 * i + 1];
+    if (id >= hdr.table_len || loc < hdr.heap_lo || loc >= hdr.heap_hi) {
+      goto done;
+    }
+  }
+
+  u64 lo = HEAP_BANKS[0].next;
+  if (lo + words > HEAP_CAP) goto done;
+  int64_t delta = (int64_t)lo - (int64_t)hdr.heap_lo;
+
+  // TABLE: intern the names past the current prefix; ids come out in order.
+  p = names;
+  for (u32 i = 0; i < hdr.table_len; i++) {
+    u32 len;
+    memcpy(&len, p, sizeof(len));
+    p += sizeof(len);
+    if (i >= TABLE_LEN) table_find((const char *)p, len);
+    p += len;
+  }
+
+  // HEAP: place the region at the start of slice 0.
+  const Term *src = (const Term *)(map + hdr.heap_off);
+  Term *dst = &HEAP[lo];
+
+  long page = sysconf(_SC_PAGESIZE);
+  uintptr_t a0 = ((uintptr_t)dst + page - 1) / page * page;
+  uintptr_t a1 = ((uintptr_t)(dst + words)) / page * page;
+  int can_map = delta == 0 && a1 > a0
+             && ((uintptr_t)dst - hdr.heap_off) % (uintptr_t)page == 0;
+  if (can_map) {
+    u64 head = (a0 - (uintptr_t)dst) / sizeof(Term);
+    u64 tail = (a1 - (uintptr_t)dst) / sizeof(Term);
+    memcpy(dst, src, head * sizeof(Term));
+    memcpy(dst + tail, src + tail, (words - tail) * sizeof(Term));
+    void *m = mmap((void *)a0, a1 - a0, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_FIXED, fd,
+                   (off_t)(hdr.heap_off + head * sizeof(Term)));
+    if (m == MAP_FAILED) {
+      memcpy(dst + head, src + head, (tail - head) * sizeof(Term));
+    } else {
+      g_snap_map     = m;
+      g_snap_map_len = a1 - a0;
+    }
+  } else {
+    for (u64 i = 0; i < words; i++) {
+      dst[i] = snap_relocate(src[i], delta);
+    }
+  }
+  HEAP_BANKS[0].next = lo + words;
+
+  // BOOK: definition roots move with the region.
+  for (u32 i = 0; i < hdr.book_len; i++) {
+    BOOK[book[2 * i]] = (u32)((int64_t)book[2 * i + 1] + delta);
+  }
+
+  FRESH           = hdr.fresh;
+  PARSE_FRESH_LAB = hdr.fresh_lab;
+  rc = 0;
+
+done:
+  munmap(map, size);
+  close(fd);
+  return rc;
 }
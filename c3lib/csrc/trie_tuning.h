@@ -0,0 +1,84 @@
+// Trie radix decision table shared by hvm4_bridge.c and lib/libhvm4_graph.c
+// Include after hvm4.c (uses thread_get_count).
+//
+// bench/autotune.py measures the emitters' own Bellman-Ford layout at radix
+// 2, 4, 8 and 16 per (V, threads) target and writes the winners as a
+// tab-separated table ('#' comments):
+//
+//   threads  v_max  edges  variant  radix  min_us  itrs
+//
+// Only threads, v_max and radix are used; edges and variant document the
+// measurement. Every radix does the same relaxations per round, so E does
+// not move the choice and rows are not keyed on it. Rows with a radix the
+// emitters cannot build are skipped rather than rounded.
+//
+// trie_tuning_radix(n, fallback) takes the rows of the measured thread
+// count nearest to the current one, then the row with the smallest
+// v_max >= n (the largest v_max when n exceeds them all). Without a table
+// it is `fallback`, rounded down to a power of two in [2, 16].
+
+#ifndef TRIE_TUNING_H
+#define TRIE_TUNING_H
+
+#define TRIE_TUNING_MAX 256
+
+typedef struct {
+  uint32_t threads;
+  uint32_t v_max;
+  uint32_t radix;
+} trie_tuning_row_t;
+
+static trie_tuning_row_t trie_tuning[TRIE_TUNING_MAX];
+static int               trie_tuning_len;
+
+// Loads a table, replacing the current one; NULL clears it. Returns the
+// number of rows, or -1 if the file cannot be read (the table is kept).
+static int trie_tuning_read(const char *path) {
+  if (!path) {
+    trie_tuning_len = 0;
+    return 0;
+  }
+  FILE *f = fopen(path, "r");
+  if (!f) return -1;
+  char line[512];
+  int len = 0;
+  while (fgets(line, sizeof(line), f) && len < TRIE_TUNING_MAX) {
+    if (line[0] == '#') continue;
+    unsigned t, v, e, r;
+    char variant[64];
+    if (sscanf(line, "%u %u %u %63s %u", &t, &v, &e, variant, &r) != 5) {
+      continue;
+    }
+    if (r != 2 && r != 4 && r != 8 && r != 16) continue;
+    trie_tuning[len++] = (trie_tuning_row_t){ t, v, r };
+  }
+  fclose(f);
+  trie_tuning_len = len;
+  return len;
+}
+
+static uint32_t trie_tuning_radix(uint32_t n, uint32_t fallback) {
+  uint32_t threads = thread_get_count();
+  uint32_t best_t  = 0, dt_best = UINT32_MAX;
+  for (int i = 0; i < trie_tuning_len; i++) {
+    uint32_t t  = trie_tuning[i].threads;
+    uint32_t dt = t > threads ? t - threads : threads - t;
+    if (dt < dt_best) {
+      dt_best = dt;
+      best_t  = t;
+    }
+  }
+  const trie_tuning_row_t *fit = NULL, *top = NULL;
+  for (int i = 0; i < trie_tuning_len; i++) {
+    const trie_tuning_row_t *row = &trie_tuning[i];
+    if (row->threads != best_t) continue;
+    if (row->v_max >= n && (!fit || row->v_max < fit->v_max)) fit = row;
+    if (!top || row->v_max > top->v_max) top = row;
+  }
+  uint32_t want  = fit ? fit->radix : top ? top->radix : fallback;
+  uint32_t radix = 2;
+  while (radix * 2 <= want && radix < 16) radix *= 2;
+  return radix;
+}
+
+#endif
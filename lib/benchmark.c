@@ -2,11 +2,21 @@
  * benchmark.c - Performance testing for libhvm4_graph
  * 
  * Tests scalability with 100k+ nodes using tree-structured algorithms.
+ *
+ * Usage: ./benchmark [--perf]
+ *
+ * --perf adds hardware counters (cycles, instructions, LLC/dTLB/branch
+ * misses) for the graph-building and solving phase of every benchmark;
+ * see ../bench/perf_counters.h. Counters the system does not permit are
+ * shown as "-".
  */
 
 #include "libhvm4_graph.h"
+#include "graphgen.h"
+#include "perf_counters.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/time.h>
@@ -27,20 +37,24 @@ static void print_result(const char *test, int ok, double elapsed_ms, uint32_t n
 }
 
 static hvm4_graph_t* create_sparse_graph(uint32_t n, uint32_t avg_degree, unsigned seed) {
-    srand(seed);
+    // Same generator as the bench/ drivers and bench/gen.py (chain + random
+    // deduplicated edges), so results are comparable across front ends.
+    graphgen_csr_t csr;
+    if (graphgen_uniform(&csr, n, avg_degree, seed) != 0) return NULL;
     
     hvm4_graph_t *g = hvm4_graph_new(n);
-    if (!g) return NULL;
+    if (!g) {
+        graphgen_free(&csr);
+        return NULL;
+    }
     
-    // Each node connects to ~avg_degree random neighbors
     for (uint32_t u = 0; u < n; u++) {
-        for (uint32_t k = 0; k < avg_degree; k++) {
-            uint32_t v = rand() % n;
-            uint32_t w = (rand() % 10) + 1; // Weight 1..10
-            hvm4_graph_add_edge(g, u, v, w);
+        for (uint32_t e = csr.row_ptr[u]; e < csr.row_ptr[u + 1]; e++) {
+            hvm4_graph_add_edge(g, u, csr.col_idx[e], csr.weight[e]);
         }
     }
     
+    graphgen_free(&csr);
     return g;
 }
 
@@ -93,9 +107,19 @@ static hvm4_graph_t* create_tree_graph(uint32_t depth) {
     return g;
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+    int perf = argc > 1 && strcmp(argv[1], "--perf") == 0;
+    
     printf("=== libhvm4_graph Benchmark ===\n\n");
     
+    // Counters before hvm4_init(), so the runtime's threads inherit them
+    perf_counters_t pc;
+    if (perf) {
+        perf_open(&pc);
+    } else {
+        perf_off(&pc);
+    }
+    
     // Initialize
     printf("Initializing HVM4 runtime...\n");
     hvm4_result_t result = hvm4_init();
@@ -122,7 +146,9 @@ int main(void) {
         
         printf("Building random sparse graph (%u nodes, ~%u avg degree)...\n", 
                n, avg_degree);
+        perf_begin(&pc);
         hvm4_graph_t *g = create_sparse_graph(n, avg_degree, 42);
+        perf_end(&pc, "sssp.gen");
         if (!g) {
             fprintf(stderr, "Failed to create graph\n");
             hvm4_cleanup();
@@ -137,9 +163,11 @@ int main(void) {
             return 1;
         }
         
+        perf_begin(&pc);
         double start = get_time_ms();
         result = hvm4_shortest_path(g, 0, dist);
         double elapsed = get_time_ms() - start;
+        perf_end(&pc, "sssp.run");
         
         print_result("SSSP (Bellman-Ford style)", result == HVM4_OK, elapsed, n);
         
@@ -166,7 +194,9 @@ int main(void) {
         uint32_t n = side * side;
         
         printf("Building 2D grid graph (%ux%u = %u nodes)...\n", side, side, n);
+        perf_begin(&pc);
         hvm4_graph_t *g = create_grid_graph(side);
+        perf_end(&pc, "mst.gen");
         if (!g) {
             fprintf(stderr, "Failed to create grid\n");
             hvm4_cleanup();
@@ -176,9 +206,11 @@ int main(void) {
         uint32_t mst_weight;
         uint32_t rounds = 7; // ceil(log2(10000)) + 1
         
+        perf_begin(&pc);
         double start = get_time_ms();
         result = hvm4_mst_boruvka(g, rounds, &mst_weight);
         double elapsed = get_time_ms() - start;
+        perf_end(&pc, "mst.run");
         
         print_result("MST (Borůvka)", result == HVM4_OK, elapsed, n);
         
@@ -199,7 +231,9 @@ int main(void) {
         uint32_t n = (1u << depth) - 1;
         
         printf("Building binary tree (depth %u = %u nodes)...\n", depth, n);
+        perf_begin(&pc);
         hvm4_graph_t *g = create_tree_graph(depth);
+        perf_end(&pc, "reach.gen");
         if (!g) {
             fprintf(stderr, "Failed to create tree\n");
             hvm4_cleanup();
@@ -210,9 +244,11 @@ int main(void) {
         uint32_t source = 0;     // Root
         uint32_t target = n - 1; // Rightmost leaf
         
+        perf_begin(&pc);
         double start = get_time_ms();
         result = hvm4_reachable(g, source, target, depth, &dist);
         double elapsed = get_time_ms() - start;
+        perf_end(&pc, "reach.run");
         
         print_result("Point-to-point reachability", 
                     result == HVM4_OK, elapsed, n);
@@ -235,7 +271,9 @@ int main(void) {
         
         printf("Building random graph (%u nodes, ~%u avg degree)...\n", 
                n, avg_degree);
+        perf_begin(&pc);
         hvm4_graph_t *g = create_sparse_graph(n, avg_degree, 123);
+        perf_end(&pc, "clos.gen");
         if (!g) {
             fprintf(stderr, "Failed to create graph\n");
             hvm4_cleanup();
@@ -250,9 +288,11 @@ int main(void) {
             return 1;
         }
         
+        perf_begin(&pc);
         double start = get_time_ms();
         result = hvm4_closure(g, n, matrix);
         double elapsed = get_time_ms() - start;
+        perf_end(&pc, "clos.run");
         
         print_result("Transitive closure (all-pairs)", 
                     result == HVM4_OK, elapsed, n * n);
@@ -271,6 +311,12 @@ int main(void) {
     }
     printf("\n");
     
+    if (perf) {
+        perf_print(&pc);
+        printf("\n");
+    }
+    perf_close(&pc);
+    
     // Cleanup
     hvm4_cleanup();
     
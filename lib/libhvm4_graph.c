@@ -28,6 +28,40 @@ struct hvm4_graph {
     hvm4_edge_t *edges;
 };
 
+/* ========================================================================
+ * Compaction Policy
+ * ======================================================================== */
+
+/*
+ * %gc_poll / %gc_done, the heap accounting and the policy state are shared
+ * with the C3 bridge (c3lib/csrc/gc_policy.h). The policy is off until
+ * hvm4_set_gc_policy() or HVM4_GC sets one, and only then does @repeat poll
+ * it; otherwise @repeat stays lazy.
+ */
+
+#include "../c3lib/csrc/gc_policy.h"
+
+/* ========================================================================
+ * Trie Radix Tuning
+ * ======================================================================== */
+
+/*
+ * The decision table from bench/autotune.py and its lookup are shared with
+ * the C3 bridge (c3lib/csrc/trie_tuning.h). Without a table: radix 4.
+ */
+
+#include "../c3lib/csrc/trie_tuning.h"
+
+#define TRIE_RADIX_DEFAULT 4
+
+int hvm4_trie_tuning_load(const char *path) {
+    return trie_tuning_read(path);
+}
+
+static uint32_t trie_radix_for(uint32_t n) {
+    return trie_tuning_radix(n, TRIE_RADIX_DEFAULT);
+}
+
 /* ========================================================================
  * Internal Helpers
  * ======================================================================== */
@@ -43,24 +77,13 @@ static uint32_t ceil_log2_u32(uint32_t n) {
     return rounds > 0 ? rounds : 1;
 }
 
-static uint32_t ceil_log4_u32(uint32_t n) {
-    if (n <= 4) return 1;
-    uint32_t depth = 1;
-    uint32_t cap = 4;
-    while (cap < n) {
-        depth++;
-        cap *= 4;
-    }
-    return depth;
-}
-
-static uint32_t ceil_log16_u32(uint32_t n) {
-    if (n <= 16) return 1;
+static uint32_t ceil_log_radix_u32(uint32_t n, uint32_t radix) {
+    if (n <= radix) return 1;
     uint32_t depth = 1;
-    uint32_t cap = 16;
+    uint32_t cap = radix;
     while (cap < n) {
         depth++;
-        cap *= 16;
+        cap *= radix;
     }
     return depth;
 }
@@ -174,44 +197,156 @@ static void gen_edge_list(dstring_t *ds, hvm4_graph_t *g) {
 }
 
 /**
- * Generate radix-4 trie operations for tree-structured distance arrays
+ * One #Q node of a radix-way trie: child `slot` is `at`, formatted with
+ * the slot index (e.g. "@q_set(next,val,nd,c%u)"), the others are c<i>,
+ * or #QE{} when fresh.
  */
-static void gen_trie4_ops(dstring_t *ds) {
-    // q4_get: O(log4(V)) lookup, returns @INF for missing keys
-    dstr_append(ds, "@q4_get = λ&key. λ&depth. λ{\n");
+static void gen_trie_node(dstring_t *ds, uint32_t radix, uint32_t slot,
+                          const char *at, int fresh) {
+    dstr_append(ds, "#Q{");
+    for (uint32_t i = 0; i < radix; i++) {
+        if (i > 0) dstr_append(ds, ",");
+        if (i == slot) {
+            dstr_appendf(ds, at, i);
+        } else if (fresh) {
+            dstr_append(ds, "#QE{}");
+        } else {
+            dstr_appendf(ds, "c%u", i);
+        }
+    }
+    dstr_append(ds, "}");
+}
+
+/**
+ * Generate radix-R trie operations for tree-structured distance arrays
+ * (R a power of two in [2, 16]; @DEPTH = ceil(log_R(V)))
+ */
+static void gen_trie_ops(dstring_t *ds, uint32_t radix) {
+    uint32_t last = radix - 1;
+    
+    // q_get: O(log_R(V)) lookup, returns @INF for missing keys
+    dstr_append(ds, "@q_get = λ&key. λ&depth. λ{\n");
     dstr_append(ds, "  #QE: @INF;\n");
     dstr_append(ds, "  #QL: λval. val;\n");
-    dstr_append(ds, "  #Q: λ&c0. λ&c1. λ&c2. λ&c3.\n");
-    dstr_append(ds, "    ! &slot = key % 4;\n");
-    dstr_append(ds, "    ! &next = key / 4;\n");
+    dstr_append(ds, "  #Q:");
+    for (uint32_t i = 0; i < radix; i++) dstr_appendf(ds, " λ&c%u.", i);
+    dstr_append(ds, "\n");
+    dstr_appendf(ds, "    ! &slot = key %% %u;\n", radix);
+    dstr_appendf(ds, "    ! &next = key / %u;\n", radix);
     dstr_append(ds, "    ! &nd = depth - 1;\n");
-    dstr_append(ds, "    λ{0: @q4_get(next,nd,c0); 1: @q4_get(next,nd,c1); ");
-    dstr_append(ds, "2: @q4_get(next,nd,c2); λn. @q4_get(next,nd,c3)}(slot)\n");
+    dstr_append(ds, "    λ{");
+    for (uint32_t i = 0; i < last; i++) {
+        dstr_appendf(ds, "%u: @q_get(next,nd,c%u); ", i, i);
+    }
+    dstr_appendf(ds, "λn. @q_get(next,nd,c%u)}(slot)\n", last);
     dstr_append(ds, "}\n\n");
     
-    // q4_set: O(log4(V)) insert/update
-    dstr_append(ds, "@q4_set = λ&key. λ&val. λ&depth. λ{\n");
+    // q_set: O(log_R(V)) insert/update
+    dstr_append(ds, "@q_set = λ&key. λ&val. λ&depth. λ{\n");
     dstr_append(ds, "  #QL: λold. #QL{val};\n");
     dstr_append(ds, "  #QE: λ{0: #QL{val}; λn.\n");
-    dstr_append(ds, "    ! &slot = key % 4; ! &next = key / 4; ! &nd = depth - 1;\n");
-    dstr_append(ds, "    @q4_set_slot(slot, @q4_set(next, val, nd, #QE{}))}(depth);\n");
-    dstr_append(ds, "  #Q: λ&c0. λ&c1. λ&c2. λ&c3.\n");
-    dstr_append(ds, "    ! &slot = key % 4; ! &next = key / 4; ! &nd = depth - 1;\n");
-    dstr_append(ds, "    λ{0: #Q{@q4_set(next,val,nd,c0),c1,c2,c3};\n");
-    dstr_append(ds, "    1: #Q{c0,@q4_set(next,val,nd,c1),c2,c3};\n");
-    dstr_append(ds, "    2: #Q{c0,c1,@q4_set(next,val,nd,c2),c3};\n");
-    dstr_append(ds, "    λn. #Q{c0,c1,c2,@q4_set(next,val,nd,c3)}}(slot)\n");
+    dstr_appendf(ds, "    ! &slot = key %% %u; ! &next = key / %u; ! &nd = depth - 1;\n",
+                 radix, radix);
+    dstr_append(ds, "    @q_set_slot(slot, @q_set(next, val, nd, #QE{}))}(depth);\n");
+    dstr_append(ds, "  #Q:");
+    for (uint32_t i = 0; i < radix; i++) dstr_appendf(ds, " λ&c%u.", i);
+    dstr_append(ds, "\n");
+    dstr_appendf(ds, "    ! &slot = key %% %u; ! &next = key / %u; ! &nd = depth - 1;\n",
+                 radix, radix);
+    for (uint32_t i = 0; i <= last; i++) {
+        dstr_append(ds, i == 0 ? "    λ{" : "    ");
+        if (i < last) {
+            dstr_appendf(ds, "%u: ", i);
+        } else {
+            dstr_append(ds, "λn. ");
+        }
+        gen_trie_node(ds, radix, i, "@q_set(next,val,nd,c%u)", 0);
+        dstr_append(ds, i < last ? ";\n" : "}(slot)\n");
+    }
     dstr_append(ds, "}\n\n");
     
-    // q4_set_slot: create fresh 4-way branch with one child set
-    dstr_append(ds, "@q4_set_slot = λ&slot. λ&child. λ{\n");
-    dstr_append(ds, "  0: #Q{child, #QE{}, #QE{}, #QE{}};\n");
-    dstr_append(ds, "  1: #Q{#QE{}, child, #QE{}, #QE{}};\n");
-    dstr_append(ds, "  2: #Q{#QE{}, #QE{}, child, #QE{}};\n");
-    dstr_append(ds, "  λn. #Q{#QE{}, #QE{}, #QE{}, child}\n");
+    // q_set_slot: create fresh R-way branch with one child set
+    dstr_append(ds, "@q_set_slot = λ&slot. λ&child. λ{\n");
+    for (uint32_t i = 0; i <= last; i++) {
+        if (i < last) {
+            dstr_appendf(ds, "  %u: ", i);
+        } else {
+            dstr_append(ds, "  λn. ");
+        }
+        gen_trie_node(ds, radix, i, "child", 1);
+        dstr_append(ds, i < last ? ";\n" : "\n");
+    }
     dstr_append(ds, "}(slot)\n\n");
 }
 
+/**
+ * Generate bulk construction and in-order extraction for the radix-R trie
+ * (the @trie_fill_n / @trie_to_list of lib/_trie_lib_.hvm4):
+ *   @q_fill_n(n, depth, val)   - every key below n set to val, subtrees
+ *                                holding no such key left #QE{}
+ *   @q_to_list(n, depth, trie) - [v0, .., v(n-1)], @INF for unset keys
+ * A node's keys are key, key + stride, ... (stride = R^level); the R
+ * children are built and flattened by independent calls, and @q_weave
+ * merges their lists round-robin back into key order.
+ */
+static void gen_trie_bulk_ops(dstring_t *ds, uint32_t radix) {
+    // q_fill_n: O(V) nodes, one call per child
+    dstr_append(ds, "@q_fill_n = λn. λdepth. λval. @q_fill_go(n, 0, 1, depth, val)\n");
+    dstr_append(ds, "@q_fill_go = λ&n. λ&key. λ&stride. λ&depth. λ&val. λ{0: #QE{}; λk.\n");
+    dstr_append(ds, "  λ{0: #QL{val}; λd.\n");
+    dstr_appendf(ds, "    ! &nd = depth - 1; ! &s2 = stride * %u;\n", radix);
+    dstr_append(ds, "    #Q{");
+    for (uint32_t i = 0; i < radix; i++) {
+        if (i > 0) dstr_append(ds, ",");
+        dstr_appendf(ds, "@q_fill_go(n,key + stride * %u,s2,nd,val)", i);
+    }
+    dstr_append(ds, "}}(depth)}(key < n)\n\n");
+
+    // q_to_list: in-order flatten, the children in parallel
+    dstr_append(ds, "@q_to_list = λn. λdepth. λtrie. @q_to_list_go(n, 0, 1, depth, trie)\n");
+    dstr_append(ds, "@q_to_list_go = λ&n. λ&key. λ&stride. λ&depth. λ{\n");
+    dstr_append(ds, "  #QE: @q_inf_run(n, key, stride);\n");
+    dstr_append(ds, "  #QL: λval. λ{0: []; λk. [val]}(key < n);\n");
+    dstr_append(ds, "  #Q:");
+    for (uint32_t i = 0; i < radix; i++) dstr_appendf(ds, " λc%u.", i);
+    dstr_append(ds, "\n");
+    dstr_appendf(ds, "    ! &nd = depth - 1; ! &s2 = stride * %u;\n", radix);
+    dstr_append(ds, "    @q_weave(");
+    for (uint32_t i = 0; i < radix; i++) {
+        if (i > 0) dstr_append(ds, ",");
+        dstr_appendf(ds, "@q_to_list_go(n,key + stride * %u,s2,nd,c%u)", i, i);
+    }
+    dstr_append(ds, ")\n}\n");
+    dstr_append(ds, "@q_inf_run = λ&n. λ&key. λ&stride. λ{0: [];\n");
+    dstr_append(ds, "  λk. @INF <> @q_inf_run(n, key + stride, stride)}(key < n)\n");
+
+    // q_weave: head of the first list, then the others rotated; stops at
+    // the first empty list (the first key >= n)
+    dstr_append(ds, "@q_weave = λ{[]:");
+    for (uint32_t i = 1; i < radix; i++) dstr_appendf(ds, " λc%u.", i);
+    dstr_append(ds, " []; <>: λh. λt.");
+    for (uint32_t i = 1; i < radix; i++) dstr_appendf(ds, " λc%u.", i);
+    dstr_append(ds, " h <> @q_weave(");
+    for (uint32_t i = 1; i < radix; i++) dstr_appendf(ds, "c%u,", i);
+    dstr_append(ds, "t)}\n\n");
+}
+
+/**
+ * @repeat: lazy unless a compaction policy is set, in which case it is
+ * strict and polls the policy before every round
+ */
+static void gen_repeat(dstring_t *ds) {
+    if (!gc_polling()) {
+        dstr_append(ds, "@repeat = λ&f. λ&x. λ{0: x; λn. @repeat(f, f(x), n - 1)}\n\n");
+        return;
+    }
+    dstr_append(ds, "@repeat = λf. λ&x. λ{0: x; λn. @repeat_gc(%gc_poll(x), f, x, n - 1)}\n");
+    dstr_append(ds, "@repeat_gc = λ{\n");
+    dstr_append(ds, "  0: λ&f. λx. λn. @repeat(f, f(x), n);\n");
+    dstr_append(ds, "  λc. λ&f. λx. λn. @repeat(f, f(%gc_done(%compact(x))), n)\n");
+    dstr_append(ds, "}\n\n");
+}
+
 /**
  * Extract numeric results from HVM4 term
  */
@@ -304,6 +439,7 @@ static void reset_hvm4(void) {
     // Reset free lists
     heap_free_reset();
     heap_init_slices();
+    heap_mark_bases();
     
     // Free PARSE_SEEN_FILES
     for (u32 i = 0; i < PARSE_SEEN_FILES_LEN; i++) {
@@ -329,6 +465,7 @@ static void reset_hvm4(void) {
     // Clear primitive definitions and re-register
     memset(PRIM_DEFS, 0, sizeof(PRIM_DEFS));
     prim_init();
+    gc_prims_register();
 }
 
 /* ========================================================================
@@ -359,7 +496,18 @@ hvm4_result_t hvm4_init(void) {
     }
     
     heap_init_slices();
+    heap_mark_bases();
     prim_init();
+    gc_prims_register();
+    
+    // Trie radix decision table (bench/autotune.py)
+    const char *tune_env = getenv("HVM4_TRIE_TUNING");
+    if (tune_env && tune_env[0] && hvm4_trie_tuning_load(tune_env) < 0) {
+        fprintf(stderr, "HVM4_TRIE_TUNING: cannot read %s\n", tune_env);
+    }
+    
+    // Compaction policy from env: off | every:N | heap:WORDS
+    gc_policy_from_env();
     
     DEBUG = 0;
     SILENT = 0;
@@ -383,6 +531,26 @@ void hvm4_cleanup(void) {
     TABLE = NULL;
 }
 
+/* ========================================================================
+ * Public API: Compaction Policy & Stats
+ * ======================================================================== */
+
+void hvm4_set_gc_policy(hvm4_gc_mode_t mode, uint64_t param) {
+    gc_set_policy((int)mode, param);
+}
+
+void hvm4_get_stats(hvm4_stats_t *stats) {
+    if (!stats) return;
+    uint64_t itrs = 0;
+    for (u32 t = 0; t < MAX_THREADS; t++) {
+        itrs += WNF_ITRS_BANKS[t].itrs;
+    }
+    stats->itrs = itrs;
+    stats->heap_words = heap_used();
+    stats->gc_count = gc_count;
+    stats->gc_reclaimed = gc_reclaimed;
+}
+
 /* ========================================================================
  * Public API: Graph Construction
  * ======================================================================== */
@@ -603,44 +771,42 @@ hvm4_result_t hvm4_shortest_path(hvm4_graph_t *g,
     dstring_t ds;
     dstr_init(&ds);
     
-    uint32_t depth = ceil_log4_u32(g->n_nodes);
+    uint32_t radix = trie_radix_for(g->n_nodes);
+    uint32_t depth = ceil_log_radix_u32(g->n_nodes, radix);
     uint32_t rounds = g->n_nodes > 1 ? g->n_nodes - 1 : 1;
     
     dstr_appendf(&ds, "@INF = %u\n", INF);
     dstr_appendf(&ds, "@DEPTH = %u\n\n", depth);
     
     // Generate trie ops
-    gen_trie4_ops(&ds);
+    gen_trie_ops(&ds, radix);
+    gen_trie_bulk_ops(&ds, radix);
     
     // Edge relaxation
     dstr_append(&ds, "@relax_edge = λ&dist. λ{#Edge: λ&u. λ&v. λw.\n");
-    dstr_append(&ds, "  ! &du = @q4_get(u, @DEPTH, dist);\n");
+    dstr_append(&ds, "  ! &du = @q_get(u, @DEPTH, dist);\n");
     dstr_append(&ds, "  ! &new_d = du + w;\n");
-    dstr_append(&ds, "  ! &dv = @q4_get(v, @DEPTH, dist);\n");
-    dstr_append(&ds, "  λ{0: dist; λn. @q4_set(v, new_d, @DEPTH, dist)}(new_d < dv)}\n\n");
+    dstr_append(&ds, "  ! &dv = @q_get(v, @DEPTH, dist);\n");
+    dstr_append(&ds, "  λ{0: dist; λn. @q_set(v, new_d, @DEPTH, dist)}(new_d < dv)}\n\n");
     
     // Fold over edge list
     dstr_append(&ds, "@foldl = λ&f. λ&acc. λ{[]: acc; <>: λh. λt. @foldl(f, f(acc, h), t)}\n");
     dstr_append(&ds, "@relax_round = λdist. @foldl(@relax_edge, dist, @edges)\n");
-    dstr_append(&ds, "@repeat = λ&f. λ&x. λ{0: x; λn. @repeat(f, f(x), n - 1)}\n\n");
+    gen_repeat(&ds);
     
     // Edge list
     gen_edge_list(&ds, g);
     dstr_append(&ds, "\n");
     
-    // Initial distance
-    dstr_appendf(&ds, "@init_dist = @q4_set(%u, 0, @DEPTH, #QE{})\n", source);
+    // Initial distance: all @INF in one parallel build, then the source
+    dstr_appendf(&ds, "@init_dist = @q_set(%u, 0, @DEPTH, @q_fill_n(%u, @DEPTH, @INF))\n",
+                 source, g->n_nodes);
     
     // Run rounds
     dstr_appendf(&ds, "@bf = @repeat(@relax_round, @init_dist, %u)\n\n", rounds);
     
-    // Extract all distances
-    dstr_append(&ds, "@main = [");
-    for (uint32_t i = 0; i < g->n_nodes; i++) {
-        if (i > 0) dstr_append(&ds, ", ");
-        dstr_appendf(&ds, "@q4_get(%u, @DEPTH, @bf)", i);
-    }
-    dstr_append(&ds, "]\n");
+    // Extract all distances in key order
+    dstr_appendf(&ds, "@main = @q_to_list(%u, @DEPTH, @bf)\n", g->n_nodes);
     
     // Run
     int count = run_hvm4(ds.data, dist, (int)g->n_nodes);
@@ -51,6 +51,26 @@ typedef enum {
  */
 typedef struct hvm4_graph hvm4_graph_t;
 
+/**
+ * When iterative algorithms compact the heap between rounds
+ */
+typedef enum {
+    HVM4_GC_OFF = 0,    /* never compact (default) */
+    HVM4_GC_EVERY = 1,  /* compact every `param` rounds */
+    HVM4_GC_HEAP = 2    /* compact once `param` heap words were allocated
+                           since the previous compaction */
+} hvm4_gc_mode_t;
+
+/**
+ * Counters for the most recent algorithm call
+ */
+typedef struct {
+    uint64_t itrs;          /* interactions, summed over threads */
+    uint64_t heap_words;    /* heap words in use after the call */
+    uint64_t gc_count;      /* compactions performed */
+    uint64_t gc_reclaimed;  /* heap words given back by compactions */
+} hvm4_stats_t;
+
 /* ========================================================================
  * Initialization & Cleanup
  * ======================================================================== */
@@ -71,6 +91,44 @@ hvm4_result_t hvm4_init(void);
  */
 void hvm4_cleanup(void);
 
+/* ========================================================================
+ * Memory: Compaction Policy & Stats
+ * ======================================================================== */
+
+/**
+ * Choose when round-based algorithms (hvm4_shortest_path) compact the
+ * heap. Compaction keeps peak memory bounded on long runs at some cost
+ * in throughput. Also settable at init via HVM4_GC=off|every:N|heap:WORDS.
+ * Until a policy other than off is set, the round loop stays lazy and does
+ * not poll the policy at all.
+ *
+ * @param mode   HVM4_GC_OFF, HVM4_GC_EVERY or HVM4_GC_HEAP
+ * @param param  Rounds (EVERY) or heap words (HEAP); 0 is treated as 1
+ */
+void hvm4_set_gc_policy(hvm4_gc_mode_t mode, uint64_t param);
+
+/**
+ * Read interaction, heap and compaction counters of the last call.
+ *
+ * @param[out] stats  Filled with the counters
+ */
+void hvm4_get_stats(hvm4_stats_t *stats);
+
+/* ========================================================================
+ * Trie Radix Tuning
+ * ======================================================================== */
+
+/**
+ * Load the trie radix decision table written by bench/autotune.py.
+ * hvm4_shortest_path() then sizes its distance trie by the table row for
+ * the graph's node count and the current thread count, instead of the
+ * default radix 4. Also loaded at init from HVM4_TRIE_TUNING=FILE.
+ *
+ * @param path  Table file, or NULL to drop the table (back to radix 4)
+ * @return      Number of rows loaded, or -1 if the file cannot be read
+ */
+int hvm4_trie_tuning_load(const char *path);
+
 /* ========================================================================
  * Graph Construction
  * ======================================================================== */
@@ -164,7 +222,8 @@ hvm4_result_t hvm4_mst_boruvka(hvm4_graph_t *g,
 /**
  * Compute shortest distances from a source node.
  * 
- * Uses radix-4 trie for O(log_4 n) tree depth. Runs V-1 relaxation rounds.
+ * Uses radix-4 trie for O(log_4 n) tree depth. Runs V-1 relaxation rounds,
+ * compacting between rounds as set by hvm4_set_gc_policy().
  * Scales to 2M nodes.
  * 
  * @param g           Graph handle